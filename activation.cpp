@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "activation.h"
+#include "ai.h"
+#include "constants.h"
+
+using namespace std;
+
+AIH::Activation AIH::activationNamed(string name) {
+    /*
+    Gets the activation function with the given name.
+    */
+    if (name == "tanh") return TANH;
+    if (name == "relu") return RELU;
+    if (name == "hard_sigmoid") return HARD_SIGMOID;
+    if (name != "sigmoid") cout << "Unknown activation " << name << ", using sigmoid\n";
+    return SIGMOID;
+}
+
+string AIH::activationName(Activation f) {
+    /*
+    Gets the name of an activation function.
+    */
+    if (f == TANH) return "tanh";
+    if (f == RELU) return "relu";
+    if (f == HARD_SIGMOID) return "hard_sigmoid";
+    return "sigmoid";
+}
+
+AIH::Activation AIH::layerActivation(int layer) {
+    /*
+    ACTIVATIONS lists the activation of each layer after the input layer.
+    Layers past the end of the list use the last one listed.
+    */
+    vector<string> names;
+    stringstream ss(ACTIVATIONS);
+    string cur;
+    while (getline(ss, cur, ',')) {
+        if (cur != "") names.push_back(cur);
+    }
+    if (names.empty() || layer <= 0) return SIGMOID;
+    return activationNamed(names[min(layer - 1, (int)names.size() - 1)]);
+}
+
+AIH::real AIH::fastTanh(real x) {
+    /*
+    Rational approximation of tanh. Past |x| = 7.9 the result is already
+    within rounding of 1, so the input is clamped there.
+    */
+    x = min(max(x, (real)-7.90531110763549805), (real)7.90531110763549805);
+    real x2 = x * x;
+    real p = -2.76076847742355e-16;
+    p = p * x2 + (real)2.00018790482477e-13;
+    p = p * x2 + (real)-8.60467152213735e-11;
+    p = p * x2 + (real)5.12229709037114e-08;
+    p = p * x2 + (real)1.48572235717979e-05;
+    p = p * x2 + (real)6.37261928875436e-04;
+    p = p * x2 + (real)4.89352455891786e-03;
+    p = p * x;
+    real q = 1.19825839466702e-06;
+    q = q * x2 + (real)1.18534705686654e-04;
+    q = q * x2 + (real)2.26843463243900e-03;
+    q = q * x2 + (real)4.89352518554385e-03;
+    return p / q;
+}
+
+AIH::real AIH::fastSigmoid(real x) {
+    /*
+    Sigmoid through the identity sigmoid(x) = 0.5 + 0.5 tanh(x / 2), with the
+    same clamping to [-5, 5] as accs.
+    */
+    x = min(max(x, (real)-5), (real)5);
+    return (real)0.5 + (real)0.5 * fastTanh((real)0.5 * x);
+}
+
+AIH::real AIH::activation(Activation f, real x) {
+    /*
+    Applies an activation function to a single value.
+    */
+    if (f == TANH) return FAST_ACTIVATION ? fastTanh(x) : tanh(x);
+    if (f == RELU) return max(x, (real)0);
+    if (f == HARD_SIGMOID) return min(max((real)0.2 * x + (real)0.5, (real)0), (real)1);
+    return FAST_ACTIVATION ? fastSigmoid(x) : accs(x);
+}
+
+void AIH::activate(Activation f, real* v, int n) {
+    /*
+    Applies an activation function to a whole array. The function is picked
+    once outside the loop and every loop body is free of branches and calls
+    to exp, so the compiler can turn each one into SIMD instructions (this file
+    is built with -O3 -fno-trapping-math so the division in fastTanh doesn't
+    stop that).
+    */
+    if (f == TANH && FAST_ACTIVATION) {
+        for (int i = 0; i < n; i ++) v[i] = fastTanh(v[i]);
+    } else if (f == TANH) {
+        for (int i = 0; i < n; i ++) v[i] = tanh(v[i]);
+    } else if (f == RELU) {
+        for (int i = 0; i < n; i ++) v[i] = max(v[i], (real)0);
+    } else if (f == HARD_SIGMOID) {
+        for (int i = 0; i < n; i ++) v[i] = min(max((real)0.2 * v[i] + (real)0.5, (real)0), (real)1);
+    } else if (FAST_ACTIVATION) {
+        for (int i = 0; i < n; i ++) v[i] = fastSigmoid(v[i]);
+    } else {
+        for (int i = 0; i < n; i ++) v[i] = accs(v[i]);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "precision.h"
+
+namespace AIH {
+    enum Activation { // activation functions a layer can use
+        SIGMOID, // 1 / (1 + e^-x) with x clamped to [-5, 5], between 0 and 1
+        TANH, // hyperbolic tangent, between -1 and 1
+        RELU, // max(0, x)
+        HARD_SIGMOID // 0.2x + 0.5 clamped to [0, 1]
+    };
+
+    Activation activationNamed(std::string name); // parse a name like "tanh", SIGMOID if unknown
+    std::string activationName(Activation f); // inverse of activationNamed
+    Activation layerActivation(int layer); // activation of a layer according to ACTIVATIONS
+
+    real activation(Activation f, real x); // apply f to one value
+    void activate(Activation f, real* v, int n); // apply f to n values in place
+
+    /*
+    Fast paths used when FAST_ACTIVATION is set. tanh is a rational function
+    of odd degree 13 over even degree 6, evaluated without branches so whole
+    arrays can be vectorized, and sigmoid(x) is computed as 0.5 + 0.5 tanh(x / 2).
+    Measured maximum absolute error against std::tanh and std::exp:
+        fastTanh: 2.7e-7 (largest where tanh saturates past |x| = 7.9)
+        fastSigmoid: 1.3e-8 over the clamped range [-5, 5]
+    In a float build (see precision.h) they are 3.2e-7 and 1.3e-7.
+    */
+    real fastTanh(real x);
+    real fastSigmoid(real x);
+}
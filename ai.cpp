@@ -4,26 +4,80 @@
 #include <random>
 #include <string>
 #include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
 
 #include "ai.h"
+#include "genetic.h"
 #include "constants.h"
 
 using namespace std;
 
+/*
+Numbers
+*/
+
+#ifdef __cpp_lib_to_chars
+template <typename T> char* writeNumber(char* p, char* end, T v) {
+    /*
+    Writes the shortest text that reads back as exactly v and returns
+    where it ends.
+    */
+    return to_chars(p, end, v).ptr;
+}
+
+const char* readNumber(const char* p, const char* end, double& v) {
+    /*
+    Reads a number starting at p, returns where it ends or NULL if there
+    is none.
+    */
+    from_chars_result r = from_chars(p, end, v);
+    return r.ec == errc() ? r.ptr : NULL;
+}
+#else
+// Standard libraries without floating point to_chars and from_chars, like
+// libc++ before LLVM 20, write enough digits to read back exactly instead
+// of the fewest, and read with strtod.
+char* writeNumber(char* p, char* end, int v) {
+    return p + snprintf(p, end - p, "%d", v);
+}
+
+char* writeNumber(char* p, char* end, double v) {
+    return p + snprintf(p, end - p, "%.17g", v);
+}
+
+char* writeNumber(char* p, char* end, float v) {
+    return p + snprintf(p, end - p, "%.9g", v);
+}
+
+const char* readNumber(const char* p, const char* end, double& v) {
+    // strings end in a 0, so strtod doesn't read past them
+    char* stop;
+    errno = 0;
+    v = strtod(p, &stop);
+    if (stop == p || stop > end || (errno == ERANGE && isinf(v))) return NULL;
+    return stop;
+}
+#endif
+
 /*
 Neuron
 */
 
-AIH::Neuron::Neuron(int wsize, double bi) {
+AIH::Neuron::Neuron(int wsize, real bi) {
     /*
     Constructor for Neuron, sets all weights to 0.
     */
-    weights = vector<double> (wsize, 0);
+    weights = vector<real> (wsize, 0);
     bias = bi;
     value = 0;
 }
 
-AIH::Neuron::Neuron(vector<double> we, double bi) {
+AIH::Neuron::Neuron(vector<real> we, real bi) {
     /*
     More specific constructor for Neuron.
     */
@@ -47,70 +101,143 @@ AIH::Layer::Layer(Layer* prevl, int nexsize, int size) {
     
     neurons = vector<Neuron*> ();
     for (int i = 0; i < size; i ++) {
-        vector<double> gw;
+        vector<real> gw;
         // randomly generate weights
         for (int j = 0; j < nexsize; j ++) gw.push_back(dist(mt));
 
         neurons.push_back(new Neuron(gw, dist(mt)));
     }
     prev = prevl;
+    vals = vector<real> (size, 0);
+    act = SIGMOID;
+    sums = vector<real> (size, 0);
+    seen = vector<real> (prev ? prev->neurons.size() : 0, 0);
+    stale = -1;
 }
 
-vector<double> AIH::Layer::showVal() {
+vector<AIH::real> AIH::Layer::showVal() {
     /*
     Gets a vector of values of the neurons in the layer.
     */
-    vector<double> ns;
+    vector<real> ns;
     for (Neuron* n : prev->neurons) {
         ns.push_back(n->value);
     }
     return ns;
 }
 
-vector<vector<double>> AIH::Layer::showWM() {
+vector<vector<AIH::real>> AIH::Layer::showWM() {
     /*
     Get matrix of weights, where each row has the weights of one neuron in the previous layer
     and each column has weights of multiple previous layer neurons connecting to one neuron
     in the current layer.
     */
-    vector<vector<double>> res;
+    vector<vector<real>> res;
     for (int j = 0; j < prev->neurons.size(); j ++) {
         res.push_back(prev->neurons[j]->weights);
     }
     return res;
 }
 
-vector<double> AIH::Layer::getVal() {
+const vector<AIH::real>& AIH::Layer::getVal() {
     /*
-    Gets and sets new values for the layer's neurons
+    Gets new values for the layer's neurons. The result is kept in vals,
+    which is reused every time so that no memory is allocated.
     */
     if (DEBUG) cout << "<getVal>\n";
     // If input layer, don't try to get value
     if (!prev) {
-        return {};
-    }
-    // get weight matrix and value vector
-    vector<vector<double>> wm = AIH::Layer::showWM(); // row size: prev neurons; col size: new neurons
-    vector<double> va = AIH::Layer::showVal(); // size: prev neurons
-    // matrix multiply the two variables
-    // loop through columns since we want weights from all prev neurons
-    vector<double> vres (wm[0].size(), 0); // size: new neurons
-    for (int i = 0; i < wm.size(); i ++) {
-        for (int j = 0; j < wm[i].size(); j ++) {
-            vres[j] += wm[i][j] * va[i];
+        return vals;
+    }
+    if (!rowStart.empty()) {
+        // sparse: each row only holds the connections that are left
+        for (int j = 0; j < neurons.size(); j ++) {
+            real sum = 0;
+            for (int e = rowStart[j]; e < rowStart[j + 1]; e ++) {
+                sum += wts[e] * prev->neurons[cols[e]]->value;
+            }
+            vals[j] = sum - neurons[j]->bias;
         }
+        activate(act, vals.data(), neurons.size());
+        return vals;
     }
-    // create new vector vals that stores the final result
-    vector<double> vals (neurons.size(), 0);
+    // matrix multiply the previous layer's weights with its values
+    // loop through the previous neurons since each holds its weights to every new neuron
+    for (int i = 0; i < neurons.size(); i ++) vals[i] = 0;
+    for (Neuron* p : prev->neurons) {
+        for (int j = 0; j < neurons.size(); j ++) {
+            vals[j] += p->weights[j] * p->value;
+        }
+    }
+    // subtracts bias and applies the activation function to the whole layer at once
+    for (int i = 0; i < neurons.size(); i ++) {
+        vals[i] -= neurons[i]->bias;
+    }
+    activate(act, vals.data(), neurons.size());
     for (int i = 0; i < neurons.size(); i ++) {
-        // subtracts bias and applies sigmoid function
-        vals[i] = accs(vres[i] - neurons[i]->bias);
         if (DEBUG) cout << vals[i] << " ";
     }
     if (DEBUG) cout << "\n</getVal>\n";
     return vals;
 }
 
+const vector<AIH::real>& AIH::Layer::getValIncremental() {
+    /*
+    Gets new values like getVal, but keeps the weighted sums and the inputs
+    they were made from between calls and only adds the change of inputs
+    that differ. Ray readings mostly stay the same from one tick to the next
+    (nothing in sight reads exactly 1), so this costs as much as the part of
+    the scene that moved. Every INCREMENTAL_REFRESH calls the sums are
+    computed from scratch again so rounding errors can't pile up.
+    */
+    if (!prev) {
+        return vals;
+    }
+    int inputs = prev->neurons.size();
+    if (stale < 0 || stale >= INCREMENTAL_REFRESH) {
+        fill(sums.begin(), sums.end(), 0);
+        fill(seen.begin(), seen.end(), 0);
+        stale = 0;
+    }
+    stale ++;
+    for (int i = 0; i < inputs; i ++) {
+        Neuron* p = prev->neurons[i];
+        real d = p->value - seen[i];
+        if (d == 0) continue;
+        seen[i] = p->value;
+        for (int j = 0; j < neurons.size(); j ++) {
+            sums[j] += p->weights[j] * d;
+        }
+    }
+    for (int i = 0; i < neurons.size(); i ++) {
+        vals[i] = sums[i] - neurons[i]->bias;
+    }
+    activate(act, vals.data(), neurons.size());
+    return vals;
+}
+
+void AIH::Layer::compress() {
+    /*
+    Stores the incoming connections in compressed sparse row form: row j
+    lists the previous neurons connected to neuron j and their weights,
+    leaving out the ones that were pruned to 0.
+    */
+    rowStart.clear();
+    cols.clear();
+    wts.clear();
+    if (!prev) return;
+    rowStart.push_back(0);
+    for (int j = 0; j < neurons.size(); j ++) {
+        for (int i = 0; i < prev->neurons.size(); i ++) {
+            real w = prev->neurons[i]->weights[j];
+            if (w == 0) continue;
+            cols.push_back(i);
+            wts.push_back(w);
+        }
+        rowStart.push_back(cols.size());
+    }
+}
+
 void AIH::Layer::clear() {
     /*
     Clear all neurons in the layer of values.
@@ -135,47 +262,60 @@ AIH::Network::Network() {
         // otherwise set it to the previous layer in the vector
         Layer* prev = i == 0 ? NULL : res[i - 1];
         res.push_back(new Layer(prev, sizes[i + 1], sizes[i]));
+        res.back()->act = layerActivation(i);
     }
     layers = res;
+    outputs = vector<real> (layers.back()->neurons.size(), 0);
+    sparse = false;
 }
 
 AIH::Network::Network(string stored) {
     /*
     Network constructor. Uses stored weights and biases to 
-    inititalize.
+    inititalize. Sparse networks start with "sparse," and only list
+    the connections that weren't pruned.
     */
     vector<double> vals;
-    string cur = "";
-    for (char c : stored) {
-        if (c == ',') {
-            if (cur != "") {
-                vals.push_back(stod(cur));
-            }
-            cur = "";
-        } else {
-            cur += c;
-        }
+    bool valid = parseNetwork(stored, vals, sparse);
+    if (!valid) {
+        // the layers below still get made, with the random weights a new network has
+        cout << "Stored network doesn't match sizes, generating randomly\n";
+        sparse = false;
     }
-    vector<vector<pair<double, vector<double>>>> parsed;
     int nstart = 0;
     vector<Layer*> res;
     for (int i = 0; i < sizes.size() - 1; i ++) {
         // each layer
         Layer* prev = i == 0 ? NULL : res[i - 1];
         Layer* next = new Layer(prev, sizes[i + 1], sizes[i]);
-        for (int j = 0; j < sizes[i]; j ++) {
-            next->neurons[j]->bias = vals[nstart];
-            for (int k = 0; k < sizes[i + 1]; k ++) {
-                next->neurons[j]->weights[k] = vals[nstart + k + 1];
+        next->act = layerActivation(i);
+        for (int j = 0; valid && j < sizes[i]; j ++) {
+            // each neuron
+            Neuron* n = next->neurons[j];
+            n->bias = vals[nstart];
+            if (sparse) {
+                // bias, amount of connections, then index and weight of each
+                int amount = vals[nstart + 1];
+                fill(n->weights.begin(), n->weights.end(), 0);
+                for (int k = 0; k < amount; k ++) {
+                    n->weights[(int)vals[nstart + 2 + 2 * k]] = vals[nstart + 3 + 2 * k];
+                }
+                nstart += 2 + 2 * amount;
+            } else {
+                for (int k = 0; k < sizes[i + 1]; k ++) {
+                    n->weights[k] = vals[nstart + k + 1];
+                }
+                nstart += 1 + sizes[i + 1];
             }
         }
         res.push_back(next);
-        nstart += 1 + sizes[i + 1];
     }
     layers = res;
+    outputs = vector<real> (layers.back()->neurons.size(), 0);
+    if (sparse) compress();
 }
 
-vector<double> AIH::Network::run() {
+const vector<AIH::real>& AIH::Network::run() {
     /*
     Simulate the neural network and set values.
     */
@@ -187,42 +327,69 @@ vector<double> AIH::Network::run() {
     // get and set values for each successive layer
     for (int i = 1; i < layers.size(); i ++) {
         if (DEBUG) cout << "Layer " << i + 1 << ":\n";
-        // call getVal
-        vector<double> vals = layers[i]->getVal();
+        // call getVal, the first hidden layer is the one whose inputs barely change between runs
+        const vector<real>& vals = INCREMENTAL && i == 1 ? layers[i]->getValIncremental() : layers[i]->getVal();
         // set neuron values 
         for (int j = 0; j < layers[i]->neurons.size(); j ++) {
             layers[i]->neurons[j]->value = vals[j];
         }
     }
     // get output neurons' values
-    vector<double> res;
     for (int i = 0; i < layers.back()->neurons.size(); i ++) {
-        res.push_back(layers.back()->neurons[i]->value);
+        outputs[i] = layers.back()->neurons[i]->value;
     }
     if (DEBUG) cout << "</run>\n";
-    return res;
+    return outputs;
 }
 
 string AIH::Network::store(string path) {
     /*
     Stores weights and biases of each layer into a string. Optionally
     stores them in a file if a path to the text file is provided.
+    Sparse networks store the amount of connections of each neuron
+    followed by the index and weight of each connection. Values are written
+    with writeNumber, as text that reads back as exactly the same value,
+    into a string sized for the longest possible text once.
     */
-    string res = "";
-    for (int i = 0; i < layers.size(); i ++) {
-        Layer* l = layers[i];
-        for (int j = 0; j < l->neurons.size(); j ++) {
-            Neuron* n = l->neurons[j];
-            res += to_string(n->bias) + ",";
-            for (int k = 0; k < n->weights.size(); k ++) {
-                res += to_string(n->weights[k]) + ",";
+    size_t values = 0;
+    for (Layer* l : layers) {
+        for (Neuron* n : l->neurons) {
+            if (!sparse) {
+                values += 1 + n->weights.size();
+                continue;
             }
-        } 
+            values += 2;
+            for (real w : n->weights) values += 2 * (w != 0);
+        }
     }
-    if (res.size() > 0) {
-        // remove last comma
-        res.pop_back();
+    // a double takes at most 24 characters, and every value gets a comma
+    string res(7 + 25 * values, ' ');
+    char* p = &res[0];
+    char* end = p + res.size();
+    auto put = [&p, end] (auto v) {
+        p = writeNumber(p, end, v);
+        *p ++ = ',';
+    };
+    if (sparse) p = copy_n("sparse,", 7, p);
+    for (Layer* l : layers) {
+        for (Neuron* n : l->neurons) {
+            put(n->bias);
+            if (sparse) {
+                int amount = 0;
+                for (real w : n->weights) amount += w != 0;
+                put(amount);
+                for (int k = 0; k < n->weights.size(); k ++) {
+                    if (n->weights[k] == 0) continue;
+                    put(k);
+                    put(n->weights[k]);
+                }
+                continue;
+            }
+            for (real w : n->weights) put(w);
+        }
     }
+    // remove last comma
+    res.resize(values > 0 ? p - res.data() - 1 : p - res.data());
     if (path != "") {
         ofstream fout;
         fout.open(path);
@@ -234,32 +401,164 @@ string AIH::Network::store(string path) {
 
 void AIH::Network::mutate(double amount) {
     /*
-    Changes the weights and biases of each layer using randomness.
+    Changes the weights and biases of each layer using randomness, as a
+    batch of one (see breed in genetic.h). Pruned connections of sparse
+    networks stay pruned, and connections that end up below PRUNE_THRESHOLD
+    are pruned afterwards.
     */
-    random_device rd;
-    mt19937 mt(rd());
-    uniform_real_distribution<double> dist(-amount, amount);
+    vector<Network*> self = {this};
+    breed(self, 1, 1, amount);
+}
+
+int AIH::Network::parameters() {
+    int n = 0;
     for (int i = 0; i < layers.size(); i ++) {
-        Layer* l = layers[i];
-        for (int j = 0; j < l->neurons.size(); j ++) {
-            Neuron* n = l->neurons[j];
-            n->bias += dist(mt); n->bias = max(min(n->bias, 5.0), -5.0);
-            for (int k = 0; k < n->weights.size(); k ++) {
-                n->weights[k] += dist(mt);
-                n->weights[k] = max(min(n->weights[k], 5.0), -5.0);;
+        for (Neuron* ne : layers[i]->neurons) n += (i > 0) + ne->weights.size();
+    }
+    return n;
+}
+
+void AIH::Network::gather(double* p) {
+    for (int i = 0; i < layers.size(); i ++) {
+        for (Neuron* ne : layers[i]->neurons) {
+            if (i > 0) *p ++ = ne->bias;
+            for (real w : ne->weights) *p ++ = w;
+        }
+    }
+}
+
+void AIH::Network::scatter(const double* p) {
+    for (int i = 0; i < layers.size(); i ++) {
+        for (Neuron* ne : layers[i]->neurons) {
+            if (i > 0) ne->bias = *p ++;
+            for (real& w : ne->weights) {
+                if (!sparse || w != 0) w = *p;
+                p ++;
             }
-        } 
+        }
+    }
+    invalidate();
+}
+
+void AIH::Network::invalidate() {
+    for (Layer* l : layers) l->stale = -1;
+}
+
+void AIH::Network::prune(double threshold) {
+    /*
+    Removes every connection whose weight is smaller than threshold in
+    magnitude, and switches the network to sparse inference.
+    */
+    for (Layer* l : layers) {
+        for (Neuron* n : l->neurons) {
+            for (real& w : n->weights) {
+                if (abs(w) < threshold) w = 0;
+            }
+        }
+    }
+    sparse = true;
+    compress();
+    invalidate();
+}
+
+void AIH::Network::quantize(int bits) {
+    /*
+    Rounds every weight to a multiple of a step set per layer, so that the
+    largest weight of the layer in magnitude is 2^(bits - 1) - 1 steps.
+    Weights that round to 0 become pruned connections of sparse networks.
+    Anything but 2 to 31 bits leaves the weights as they are.
+    */
+    if (bits < 2 || bits > 31) return;
+    double levels = (1 << (bits - 1)) - 1;
+    for (Layer* l : layers) {
+        double most = 0;
+        for (Neuron* n : l->neurons) {
+            for (real w : n->weights) most = max(most, (double)abs(w));
+        }
+        if (most == 0 || levels <= 0) continue;
+        double step = most / levels;
+        for (Neuron* n : l->neurons) {
+            for (real& w : n->weights) w = round(w / step) * step;
+        }
+    }
+    if (sparse) compress();
+    invalidate();
+}
+
+void AIH::Network::compress() {
+    /*
+    Rebuilds the compressed sparse rows of every layer from the weights.
+    */
+    for (Layer* l : layers) {
+        l->compress();
     }
 }
 
+int AIH::Network::connections() {
+    /*
+    Counts the connections that haven't been pruned.
+    */
+    int res = 0;
+    for (int i = 0; i + 1 < layers.size(); i ++) {
+        for (Neuron* n : layers[i]->neurons) {
+            for (real w : n->weights) res += w != 0;
+        }
+    }
+    return res;
+}
+
 /*
 Miscellaneous
 */
 
-double AIH::accs(double wsum) { 
+bool AIH::parseNetwork(const string& stored, vector<double>& vals, bool& sparse) {
+    /*
+    Reads the values of a stored network with readNumber, straight from the
+    string and into vals sized for them up front, then walks them the way the
+    constructor will to check that they describe a network of sizes.
+    Empty values between commas are skipped like before.
+    */
+    const char* p = stored.data();
+    const char* end = p + stored.size();
+    sparse = stored.compare(0, 7, "sparse,") == 0;
+    if (sparse) p += 7;
+    vals.clear();
+    vals.reserve(count(p, end, ',') + 1);
+    while (p < end) {
+        if (*p == ',' || isspace((unsigned char)*p)) {
+            p ++;
+            continue;
+        }
+        double v;
+        const char* stop = readNumber(p, end, v);
+        if (stop == NULL || (stop < end && *stop != ',' && !isspace((unsigned char)*stop))) return false;
+        vals.push_back(v);
+        p = stop;
+    }
+    size_t at = 0;
+    for (int i = 0; i + 1 < (int)sizes.size(); i ++) {
+        for (int j = 0; j < sizes[i]; j ++) {
+            if (!sparse) {
+                at += 1 + sizes[i + 1];
+                continue;
+            }
+            if (at + 1 >= vals.size()) return false;
+            double amount = vals[at + 1];
+            if (amount < 0 || amount > sizes[i + 1] || at + 2 + 2 * amount > vals.size()) return false;
+            for (int k = 0; k < amount; k ++) {
+                double index = vals[at + 2 + 2 * k];
+                if (index < 0 || index >= sizes[i + 1] || index != (int)index) return false;
+            }
+            at += 2 + 2 * (int)amount;
+        }
+    }
+    return at == vals.size();
+}
+
+AIH::real AIH::accs(real wsum) { 
     /*
     Uses the sigmoid function to put values between 1 and 0.
     */
-    wsum = min(max(wsum, -5.0), 5.0);
-    return (1.0 / (1.0 + exp(-1 * wsum))); 
+    wsum = min(max(wsum, (real)-5), (real)5);
+    return ((real)1 / ((real)1 + exp(-1 * wsum))); 
 }
\ No newline at end of file
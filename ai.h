@@ -4,28 +4,41 @@
 #include <vector>
 #include <string>
 
+#include "activation.h"
 #include "constants.h"
 
 namespace AIH {
     struct Neuron { // represents a single neuron in the net
-        Neuron(int wsize, double bi); // constructor 1: weights are set to 0
-        Neuron(std::vector<double> we, double bi); // constructor 2: more control over weights
+        Neuron(int wsize, real bi); // constructor 1: weights are set to 0
+        Neuron(std::vector<real> we, real bi); // constructor 2: more control over weights
         
-        std::vector<double> weights; // the weights on the connections to other neurons
-        double value; // multiplied with weights to add to other neurons
-        double bias; // an offset to the weighted sum
+        std::vector<real> weights; // the weights on the connections to other neurons
+        real value; // multiplied with weights to add to other neurons
+        real bias; // an offset to the weighted sum
     };
     
     struct Layer { // represents a group of neurons
         public:
             Layer(Layer* prevl, int nexsize, int size); // constructor
-            std::vector<double> showVal(); // gets value vector
-            std::vector<std::vector<double>> showWM(); // gets weight matrix
-            std::vector<double> getVal(); // changes the values of all neurons in the layer
+            std::vector<real> showVal(); // gets value vector
+            std::vector<std::vector<real>> showWM(); // gets weight matrix
+            const std::vector<real>& getVal(); // gets the new values of all neurons in the layer
+            const std::vector<real>& getValIncremental(); // same as getVal, but only redoes the inputs that changed since the last call
             void clear(); // clears the values of neurons
+            void compress(); // builds the sparse rows from the weights of prev
             
             std::vector<Neuron*> neurons;
             Layer* prev; // the previous layer
+            Activation act; // applied to the weighted sums of this layer
+            std::vector<real> vals; // buffer getVal writes into, so running doesn't allocate
+            // incoming connections in compressed sparse row form, empty unless the network is sparse
+            std::vector<int> rowStart; // where each neuron's row starts in cols and wts
+            std::vector<int> cols; // index of the previous neuron of each connection
+            std::vector<real> wts; // weight of each connection
+            // state of getValIncremental
+            std::vector<real> sums; // weighted sums without the bias, kept between calls
+            std::vector<real> seen; // previous layer values the sums were made from
+            int stale; // calls since the sums were computed from scratch, -1 if they have to be
 
             friend struct Neuron;
             friend class Network;
@@ -36,6 +49,7 @@ namespace AIH {
             This matrix can be gotten with the showWM function.
             Then, get a one-column matrix a where the neurons correspond to the previous layer's values. 
             This one-column matrix can be gotten with the showVal function.
+            getVal does the same multiplication straight from the neurons to avoid copying them.
             */
     };
 
@@ -43,12 +57,25 @@ namespace AIH {
         public:
             Network(); // constructor
             Network(std::string stored); // reconstruct based on different weights
-            std::vector<double> run(); // gets all values for all nodes
+            const std::vector<real>& run(); // gets all values for all nodes
             std::string store(std::string path=""); // store weights and biases in a string format
             void mutate(double amount); // mutate the current weights and biases
+            void prune(double threshold); // remove small weights and switch to sparse inference
+            void quantize(int bits); // round the weights of each layer to 2^bits - 1 evenly spaced levels, bits from 2 to 31
+            void compress(); // rebuild the sparse rows of every layer after weights change
+            int connections(); // amount of connections with a weight that isn't 0
+            int parameters(); // size of the buffer gather fills, input layer biases are left out since they aren't used
+            void gather(double* p); // copy every bias and weight into p, neuron by neuron, as doubles in either precision
+            void scatter(const double* p); // inverse of gather, pruned weights of sparse networks stay 0
+            void invalidate(); // makes the next run with INCREMENTAL start from scratch, needed after weights change
 
             std::vector<Layer*> layers;
+            std::vector<real> outputs; // buffer run writes the output values into
+            bool sparse; // pruned connections are skipped when running, storing and mutating
     };
 
-    double accs(double wsum); // Implements the activation function
+    real accs(real wsum); // Implements the activation function
+    // Reads the values of a string made by Network::store into vals. Returns
+    // false unless they are numbers that fit a network of the current sizes.
+    bool parseNetwork(const std::string& stored, std::vector<double>& vals, bool& sparse);
 }
\ No newline at end of file
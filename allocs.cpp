@@ -0,0 +1,37 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "arena.h"
+
+using namespace std;
+
+/*
+Replacements of the global operator new and delete that count heap
+allocations for CHECK_ALLOCATIONS and the allocations metric. They are kept
+out of libenv.a so only programs that link allocs.o, like main, get them.
+*/
+
+static bool linked = (SDLH::allocationsCounted = true);
+
+void* operator new(size_t size) {
+    SDLH::allocationCount.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    SDLH::allocationCount.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "archive.h"
+#include "activation.h"
+#include "constants.h"
+
+using namespace std;
+
+const size_t ARCHIVE_HEADER = 16;
+
+uint64_t AIH::hashGenome(const int32_t* layers, int amount, const double* p, int n, bool sparse) {
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h] (const void* v, size_t size) {
+        const unsigned char* c = (const unsigned char*)v;
+        for (size_t i = 0; i < size; i ++) {
+            h ^= c[i];
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(&sparse, 1);
+    mix(layers, sizeof(int32_t) * amount);
+    mix(p, sizeof(double) * n);
+    return h;
+}
+
+/*
+Archive
+*/
+
+AIH::Archive::Archive(string path) {
+    /*
+    Constructor for Archive. A new file gets its header while holding the
+    lock, so two runs starting at once don't both write one.
+    */
+    this->path = path;
+    data = NULL;
+    mapped = 0;
+    end = ARCHIVE_HEADER;
+    ok = false;
+    run = chrono::system_clock::now().time_since_epoch().count() ^ ((uint64_t)getpid() << 48);
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        cout << "Couldn't open the archive " << path << "\n";
+        return;
+    }
+    flock(fd, LOCK_EX);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        unsigned char header[ARCHIVE_HEADER] = {};
+        memcpy(header, &ARCHIVE_MAGIC, 4);
+        memcpy(header + 4, &ARCHIVE_VERSION, 4);
+        if (pwrite(fd, header, ARCHIVE_HEADER, 0) != (ssize_t)ARCHIVE_HEADER) {
+            cout << "Couldn't write to the archive " << path << "\n";
+            flock(fd, LOCK_UN);
+            return;
+        }
+    }
+    flock(fd, LOCK_UN);
+    ok = true;
+    refresh();
+    if (!ok) cout << path << " isn't an archive of version " << ARCHIVE_VERSION << "\n";
+}
+
+AIH::Archive::~Archive() {
+    if (data != NULL) munmap((void*)data, mapped);
+    if (fd >= 0) close(fd);
+}
+
+void AIH::Archive::refresh() {
+    /*
+    The file is mapped with room to grow, twice its size, so the entries
+    other runs or this one append show up without mapping it again and the
+    index can keep pointing into it. Reading past the end of the file would
+    fault, so only entries that fit in it are read. An entry that doesn't fit
+    yet is being written by another run, or was cut off by a crash, and is
+    left for later.
+    */
+    struct stat st;
+    if (fstat(fd, &st) != 0) return;
+    size_t size = st.st_size;
+    if (size > mapped) {
+        vector<size_t> offsets;
+        for (auto& i : index) offsets.push_back((const unsigned char*)i.second - data);
+        if (data != NULL) munmap((void*)data, mapped);
+        mapped = max(2 * size, (size_t)1 << 20);
+        void* m = mmap(NULL, mapped, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            data = NULL;
+            mapped = 0;
+            index.clear();
+            ok = false;
+            return;
+        }
+        data = (const unsigned char*)m;
+        for (int i = 0; i < (int)index.size(); i ++) index[i].second = (const ArchiveEntry*)(data + offsets[i]);
+    }
+    uint32_t magic = 0, version = 0;
+    if (size >= ARCHIVE_HEADER) {
+        memcpy(&magic, data, 4);
+        memcpy(&version, data + 4, 4);
+    }
+    if (magic != ARCHIVE_MAGIC || version != ARCHIVE_VERSION) {
+        index.clear();
+        ok = false;
+        return;
+    }
+    size_t added = index.size();
+    while (end + sizeof(ArchiveEntry) <= size) {
+        const ArchiveEntry* e = (const ArchiveEntry*)(data + end);
+        size_t length = sizeof(ArchiveEntry) + 8 * (size_t)e->layers + 8 * (size_t)e->parameters;
+        if (e->magic != ENTRY_MAGIC || end + length > size) break;
+        index.push_back({e->cost, e});
+        hashes.insert(e->hash);
+        end += length;
+    }
+    // the new entries are sorted on their own and merged in
+    sort(index.begin() + added, index.end());
+    inplace_merge(index.begin(), index.begin() + added, index.end());
+}
+
+bool AIH::Archive::add(Network* nn, double cost) {
+    /*
+    The entry is put together in memory and written with one call at the
+    end of the file while holding the lock, after indexing what other runs
+    appended so their copies of nn are found too. Whatever follows the last
+    whole entry by then is left over from a run that crashed while writing,
+    and gets overwritten.
+    */
+    if (!ok) return false;
+    int n = nn->parameters();
+    vector<unsigned char> buffer(sizeof(ArchiveEntry) + 8 * nn->layers.size() + 8 * (size_t)n);
+    ArchiveEntry* e = (ArchiveEntry*)buffer.data();
+    int32_t* layers = (int32_t*)(buffer.data() + sizeof(ArchiveEntry));
+    double* p = (double*)(layers + 2 * nn->layers.size());
+    for (int i = 0; i < (int)nn->layers.size(); i ++) {
+        layers[2 * i] = nn->layers[i]->neurons.size();
+        layers[2 * i + 1] = nn->layers[i]->act;
+    }
+    nn->gather(p);
+    e->magic = ENTRY_MAGIC;
+    e->layers = nn->layers.size();
+    e->parameters = n;
+    e->sparse = nn->sparse;
+    e->hash = hashGenome(layers, 2 * e->layers, p, n, nn->sparse);
+    e->run = run;
+    e->cost = cost;
+
+    flock(fd, LOCK_EX);
+    refresh();
+    bool added = false;
+    if (ok && hashes.count(e->hash) == 0) {
+        if (ftruncate(fd, end) == 0 && pwrite(fd, buffer.data(), buffer.size(), end) == (ssize_t)buffer.size()) {
+            added = true;
+        } else {
+            cout << "Couldn't add to the archive " << path << "\n";
+        }
+        refresh();
+    }
+    flock(fd, LOCK_UN);
+    return added;
+}
+
+bool AIH::Archive::fits(const ArchiveEntry* e) {
+    if ((int)e->layers != (int)sizes.size() - 1) return false;
+    const int32_t* layers = (const int32_t*)(e + 1);
+    for (int i = 0; i < (int)e->layers; i ++) {
+        if (layers[2 * i] != sizes[i] || layers[2 * i + 1] != layerActivation(i)) return false;
+    }
+    return true;
+}
+
+AIH::Network* AIH::Archive::load(const ArchiveEntry* e) {
+    /*
+    Builds a network of the current sizes and copies the entry's parameters
+    in. Sparse entries keep the connections they had, since prune with a
+    threshold of 0 only drops the weights that are already 0.
+    */
+    if (!fits(e)) return NULL;
+    Network* nn = new Network();
+    nn->scatter((const double*)((const int32_t*)(e + 1) + 2 * e->layers));
+    if (e->sparse) nn->prune(0);
+    return nn;
+}
+
+int AIH::Archive::addElites(const vector<pair<double, string>>& survivors) {
+    /*
+    Used at the end of every epoch, or of every arena in steady-state
+    evolution, so both add the same networks.
+    */
+    int added = 0;
+    for (int k = 0; k < min(ARCHIVE_ELITES, (int)survivors.size()); k ++) {
+        Network nn(survivors[k].second);
+        added += add(&nn, survivors[k].first);
+    }
+    return added;
+}
+
+vector<pair<double, string>> AIH::Archive::top(int k) {
+    vector<pair<double, string>> res;
+    refresh();
+    for (auto& i : index) {
+        if ((int)res.size() >= k) break;
+        Network* nn = load(i.second);
+        if (nn == NULL) continue;
+        res.push_back({i.first, nn->store()});
+        delete nn;
+    }
+    return res;
+}
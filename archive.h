@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+
+#include "ai.h"
+
+/*
+The hall of fame: an append-only file of the best networks of every run,
+mapped into memory so a run can seed its first epoch from it.
+
+    header: "AIHF", version, 8 reserved bytes
+    entry:  ArchiveEntry, then a size and activation for each layer as
+            32 bit integers, then the parameters of Network::gather as doubles
+
+Entries are never changed once written, and each one has a hash of its
+layers and parameters so the same network is only archived once. Numbers
+are stored as the machine has them, so an archive is only read on the kind
+of machine that wrote it. Any number of runs can append to the same file,
+taking turns through an exclusive lock on it.
+*/
+
+namespace AIH {
+    const uint32_t ARCHIVE_MAGIC = 0x46484941; // "AIHF"
+    const uint32_t ARCHIVE_VERSION = 1;
+    const uint32_t ENTRY_MAGIC = 0x45484941; // "AIHE", starts every entry
+
+    struct ArchiveEntry { // layout of the start of an entry
+        uint32_t magic;
+        uint32_t layers;
+        uint32_t parameters;
+        uint32_t sparse;
+        uint64_t hash; // of the layers and parameters that follow
+        uint64_t run; // id of the run that archived it
+        double cost; // lower is better
+    };
+
+    class Archive {
+        public:
+            Archive(std::string path); // opens or creates the archive and indexes what is in it
+            ~Archive();
+            bool add(Network* nn, double cost); // archives nn unless it is already there, true if it was added
+            // archives the first ARCHIVE_ELITES of survivors, which are stored networks sorted
+            // by cost, and returns how many of them weren't there yet
+            int addElites(const std::vector<std::pair<double, std::string>>& survivors);
+            // the best k networks that fit the current sizes and activations as stored
+            // networks, best first, along with their costs
+            std::vector<std::pair<double, std::string>> top(int k);
+            Network* load(const ArchiveEntry* e); // the network of an entry, NULL if it doesn't fit sizes
+
+            bool ok; // false if the file couldn't be opened or isn't an archive
+            uint64_t run; // id of this run, stored with everything it adds
+            std::vector<std::pair<double, const ArchiveEntry*>> index; // every entry by cost, best first
+        private:
+            void refresh(); // maps the file again and indexes the entries added since the last time
+            bool fits(const ArchiveEntry* e); // whether the entry's layers match sizes and ACTIVATIONS
+
+            std::string path;
+            int fd;
+            const unsigned char* data; // the mapped file
+            size_t mapped; // bytes mapped, more than the file has so it can grow without moving
+            size_t end; // end of the last whole entry
+            std::unordered_set<uint64_t> hashes; // of every indexed entry
+    };
+
+    uint64_t hashGenome(const int32_t* layers, int amount, const double* p, int n, bool sparse); // FNV-1a over the topology and parameters
+}
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+
+#include "arena.h"
+
+using namespace std;
+
+/*
+Allocation counting
+*/
+
+atomic<long long> SDLH::allocationCount(0);
+bool SDLH::allocationsCounted = false;
+
+long long SDLH::allocations() {
+    /*
+    Gets the amount of heap allocations counted so far.
+    */
+    return allocationCount.load(memory_order_relaxed);
+}
+
+/*
+Arena
+*/
+
+SDLH::Arena::Arena(size_t size) {
+    /*
+    Constructor for Arena. Starts with a single block of the given size.
+    */
+    blocks.push_back(vector<char> (size));
+    used = 0;
+    total = 0;
+    peak = 0;
+}
+
+void SDLH::Arena::reset() {
+    /*
+    Makes all of the memory available again. If the last tick needed more
+    than one block, they are replaced by one block big enough for all of it.
+    */
+    peak = max(peak, total);
+    if (blocks.size() > 1) {
+        blocks.clear();
+        blocks.push_back(vector<char> (peak));
+    }
+    used = 0;
+    total = 0;
+}
+
+void SDLH::Arena::reserve(size_t size) {
+    /*
+    Grows the block ahead of time, so the first tick that needs this much
+    doesn't have to allocate. Only to be called between ticks.
+    */
+    if (blocks.size() == 1 && blocks.back().size() < size) {
+        blocks.back() = vector<char> (size);
+    }
+    peak = max(peak, size);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+
+namespace SDLH {
+    class Arena { // bump allocator for scratch memory that only lives for one tick
+        public:
+            Arena(size_t size); // constructor, reserves size bytes up front
+            template <typename T> T* alloc(size_t n); // get zeroed space for n plain values
+            void reset(); // frees everything at once, to be called at the start of each tick
+            void reserve(size_t size); // make sure a tick using size bytes fits in one block
+
+            size_t used; // bytes handed out from the current block
+            size_t peak; // most bytes handed out in one tick
+        private:
+            std::vector<std::vector<char>> blocks; // more than one block only while warming up
+            size_t total; // bytes handed out since the last reset
+    };
+
+    extern std::atomic<long long> allocationCount; // heap allocations counted by the operator new of allocs.cpp
+    extern bool allocationsCounted; // whether the program is linked with allocs.o, otherwise nothing is counted
+    long long allocations(); // amount of heap allocations made through operator new so far
+};
+
+template <typename T> T* SDLH::Arena::alloc(size_t n) {
+    /*
+    Hands out the next n * sizeof(T) bytes. If the current block is full a new
+    one is started, and reset merges them so later ticks fit in a single block.
+    Only meant for plain types, since no constructors or destructors are run.
+    */
+    size_t bytes = n * sizeof(T);
+    size_t start = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+    if (start + bytes > blocks.back().size()) {
+        blocks.push_back(std::vector<char> (std::max(bytes, blocks.back().size())));
+        start = 0;
+    }
+    used = start + bytes;
+    total += bytes + alignof(T);
+    T* res = (T*)(blocks.back().data() + start);
+    std::fill(res, res + n, T());
+    return res;
+}
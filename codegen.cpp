@@ -0,0 +1,137 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <set>
+
+#include "codegen.h"
+#include "activation.h"
+#include "constants.h"
+
+using namespace std;
+
+const char* scalarName() {
+    return sizeof(AIH::real) == sizeof(float) ? "float" : "double";
+}
+
+string literal(AIH::real v) {
+    /*
+    17 significant digits read back as exactly the same double. A float
+    is a double too, so in a float build that double is cast back to the
+    exact float, where a literal of fewer digits could round differently.
+    */
+    stringstream res;
+    res << setprecision(17) << v;
+    return sizeof(AIH::real) == sizeof(double) ? res.str() : "(real)" + res.str();
+}
+
+string activationSource(AIH::Activation f, string name) {
+    /*
+    A static function applying f to one value, written out the way
+    activation.cpp computes it so results match to the bit.
+    */
+    stringstream res;
+    res << "static real " << name << "(real x) {\n";
+    if (f == AIH::TANH && FAST_ACTIVATION) {
+        res << "    x = min(max(x, (real)-7.90531110763549805), (real)7.90531110763549805);\n"
+            << "    real x2 = x * x;\n"
+            << "    real p = -2.76076847742355e-16;\n"
+            << "    p = p * x2 + (real)2.00018790482477e-13;\n"
+            << "    p = p * x2 + (real)-8.60467152213735e-11;\n"
+            << "    p = p * x2 + (real)5.12229709037114e-08;\n"
+            << "    p = p * x2 + (real)1.48572235717979e-05;\n"
+            << "    p = p * x2 + (real)6.37261928875436e-04;\n"
+            << "    p = p * x2 + (real)4.89352455891786e-03;\n"
+            << "    p = p * x;\n"
+            << "    real q = 1.19825839466702e-06;\n"
+            << "    q = q * x2 + (real)1.18534705686654e-04;\n"
+            << "    q = q * x2 + (real)2.26843463243900e-03;\n"
+            << "    q = q * x2 + (real)4.89352518554385e-03;\n"
+            << "    return p / q;\n";
+    } else if (f == AIH::TANH) {
+        res << "    return tanh(x);\n";
+    } else if (f == AIH::RELU) {
+        res << "    return max(x, (real)0);\n";
+    } else if (f == AIH::HARD_SIGMOID) {
+        res << "    return min(max((real)0.2 * x + (real)0.5, (real)0), (real)1);\n";
+    } else if (FAST_ACTIVATION) {
+        // sigmoid through tanh, see fastSigmoid
+        res << "    x = min(max(x, (real)-5), (real)5);\n"
+            << "    x = (real)0.5 * x;\n"
+            << "    x = min(max(x, (real)-7.90531110763549805), (real)7.90531110763549805);\n"
+            << "    real x2 = x * x;\n"
+            << "    real p = -2.76076847742355e-16;\n"
+            << "    p = p * x2 + (real)2.00018790482477e-13;\n"
+            << "    p = p * x2 + (real)-8.60467152213735e-11;\n"
+            << "    p = p * x2 + (real)5.12229709037114e-08;\n"
+            << "    p = p * x2 + (real)1.48572235717979e-05;\n"
+            << "    p = p * x2 + (real)6.37261928875436e-04;\n"
+            << "    p = p * x2 + (real)4.89352455891786e-03;\n"
+            << "    p = p * x;\n"
+            << "    real q = 1.19825839466702e-06;\n"
+            << "    q = q * x2 + (real)1.18534705686654e-04;\n"
+            << "    q = q * x2 + (real)2.26843463243900e-03;\n"
+            << "    q = q * x2 + (real)4.89352518554385e-03;\n"
+            << "    return (real)0.5 + (real)0.5 * (p / q);\n";
+    } else {
+        // accs
+        res << "    x = min(max(x, (real)-5), (real)5);\n"
+            << "    return ((real)1 / ((real)1 + exp(-1 * x)));\n";
+    }
+    res << "}\n\n";
+    return res.str();
+}
+
+string AIH::generate(Network* nn, string name, string from) {
+    /*
+    Each layer keeps one running sum per neuron and gets one line per
+    connection, going through the previous layer's neurons in order like
+    Layer::getVal does. Every sum then sees its terms in the same order as
+    Network::run, while sums of different neurons don't wait on each other.
+    Connections with a weight of 0, which includes pruned ones, are left out.
+    Values are real, the scalar type of the build (see precision.h), and
+    weights are written so they read back exactly (see literal).
+    */
+    stringstream res;
+    res << "// " << name << " computes the outputs of " << (from == "" ? "a stored network" : from) << "\n";
+    res << "// generated by netgen, changes will be overwritten\n\n";
+    res << "#include <cmath>\n#include <algorithm>\n\nusing namespace std;\n\n";
+    res << "typedef " << scalarName() << " real;\n\n";
+    set<Activation> used;
+    for (int i = 1; i < (int)nn->layers.size(); i ++) used.insert(nn->layers[i]->act);
+    for (Activation f : used) res << activationSource(f, name + "_" + activationName(f));
+
+    int last = nn->layers.size() - 1;
+    res << "extern \"C\" void " << name << "(const real* in, real* out) {\n";
+    for (int i = 1; i <= last; i ++) {
+        Layer* l = nn->layers[i];
+        string prev = i == 1 ? "in" : "h" + to_string(i - 1);
+        string cur = "h" + to_string(i);
+        string f = name + "_" + activationName(l->act);
+        res << "    // layer " << i << "\n";
+        res << "    real " << cur << "[" << l->neurons.size() << "] = {};\n";
+        for (int k = 0; k < (int)l->prev->neurons.size(); k ++) {
+            for (int j = 0; j < (int)l->neurons.size(); j ++) {
+                real w = l->prev->neurons[k]->weights[j];
+                if (w == 0) continue;
+                res << "    " << cur << "[" << j << "] += " << literal(w) << " * " << prev << "[" << k << "];\n";
+            }
+        }
+        for (int j = 0; j < (int)l->neurons.size(); j ++) {
+            res << "    " << (i == last ? "out" : cur) << "[" << j << "] = " << f << "(" << cur << "[" << j << "] - " << literal(l->neurons[j]->bias) << ");\n";
+        }
+    }
+    res << "}\n";
+    return res.str();
+}
+
+string AIH::generateHeader(Network* nn, string name) {
+    stringstream res;
+    res << "#pragma once\n\n";
+    res << "// generated by netgen, see " << name << ".cpp\n\n";
+    res << "const int " << name << "_inputs = " << nn->layers[0]->neurons.size() << ";\n";
+    res << "const int " << name << "_outputs = " << nn->layers.back()->neurons.size() << ";\n\n";
+    res << "extern \"C\" void " << name << "(const " << scalarName() << "* in, " << scalarName() << "* out); // in has " << name << "_inputs values, out gets " << name << "_outputs\n";
+    return res.str();
+}
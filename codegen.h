@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+#include "ai.h"
+
+/*
+Turns a network into C++ source with its weights as constants and one
+statement per connection, so a finished controller can be compiled into a
+small library that needs neither this code nor a parser. The generated
+function adds up every neuron in the same order as Network::run and uses the
+same activation code, so their outputs are identical as long as both are
+built without -ffast-math or FMA contraction (-ffp-contract=off).
+*/
+
+namespace AIH {
+    // Source of extern "C" void name(const real* in, real* out) computing
+    // nn->run() for the inputs in and writing the outputs to out, in the
+    // precision of the build. Activations follow ACTIVATIONS and
+    // FAST_ACTIVATION as they are now.
+    std::string generate(Network* nn, std::string name, std::string from="");
+    std::string generateHeader(Network* nn, std::string name); // declarations to include where the function is called
+}
@@ -0,0 +1,418 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "arena.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+Defaults
+*/
+
+vector<int> sizes = {52, 7, 3, 0};
+
+int WINDOW_SIZE = 750;
+int WORLD_WIDTH = 0;
+int WORLD_HEIGHT = 0;
+
+double MAX_SPEED = 0.75;
+double MAX_ANGVEL = 4;
+int AGENT_SIZE = 15;
+int AGENT_AMOUNT = 10;
+int AGENT_HEALTH = 1;
+
+int OBSTACLE_SIZE = 10;
+int OBSTACLE_SPEED = 3;
+double OBSTACLE_COOLDOWN = 250;
+int FIRE_COST = 20;
+int HIT_COST = 125;
+int HIT_REWARD = -200;
+double NOVELTY_REWARD = 1;
+double PROXIMITY_REWARD = 7;
+double PROXIMITY_RADIUS = 75;
+
+int CONTROL_RATE = 1;
+
+int SIGHT_ANGLE = 100;
+int RAY_AMOUNT = 50;
+string SENSE_CHANNELS = "agents";
+
+bool SENSOR_CACHE = true;
+double SENSOR_TOLERANCE = 1.5;
+double SENSOR_ANGLE_TOLERANCE = 0.5;
+int SENSOR_REFRESH = 30;
+bool DEPTH_SENSING = false;
+
+bool DEBUG = false;
+bool DEBUG_WIND = true;
+
+int EPOCH_LENGTH = 800;
+int EPOCH_AMOUNT = 50;
+
+double MUTATION_AMOUNT = 0.4;
+double MUTATION_CHANCE = 0.8;
+int SURVIVOR_REPRODUCTION = 2;
+string MUTATION = "uniform";
+string CROSSOVER = "none";
+
+string ACTIVATIONS = "sigmoid";
+bool FAST_ACTIVATION = true;
+
+bool SPARSE = false;
+double PRUNE_THRESHOLD = 0.1;
+int THREADS = 0;
+double TICK_BUDGET = 0;
+string METRICS_NAME = "";
+int METRICS_EVERY = 10;
+bool INCREMENTAL = false;
+int INCREMENTAL_REFRESH = 64;
+
+bool SHOW_COSTS = true;
+bool SHOW_RAYS = false;
+
+bool HEADLESS = false;
+double FIXED_DELTA = 0;
+string NETWORK_PATH = "networks/agent.csv";
+string SWEEP_RESULTS = "networks/sweep.csv";
+string RECORD_PATH = "";
+int RECORD_EVERY = 1;
+
+bool RACE = false;
+int RACE_CANDIDATES = 40;
+int RACE_LENGTH = 100;
+double RACE_KEEP = 0.5;
+int RACE_REPEATS = 2;
+int RACE_PATIENCE = 200;
+
+bool STEADY_STATE = false;
+int STEADY_WORKERS = 0;
+int STEADY_POPULATION = 0;
+
+string ARCHIVE_PATH = "";
+int ARCHIVE_ELITES = 1;
+int ARCHIVE_SEED = 0;
+
+int EVAL_SEED = 1;
+int EVAL_WORKERS = 0;
+
+bool CHECK_ALLOCATIONS = false;
+int ALLOCATION_WARMUP = 50;
+
+string CFGH::sweepPath = "";
+vector<string> CFGH::passed;
+
+/*
+Parameter table
+*/
+
+struct Param { // a named parameter and where it lives
+    string name;
+    char type; // i: int, d: double, b: bool, s: string, v: vector<int>
+    void* ptr;
+    double lo = -HUGE_VAL; // smallest value a number may be set to
+    double hi = HUGE_VAL; // largest value a number may be set to
+};
+
+vector<Param> params() {
+    /*
+    Every parameter that can be changed at startup.
+    */
+    return {
+        {"sizes", 'v', &sizes},
+        {"WINDOW_SIZE", 'i', &WINDOW_SIZE, 1},
+        {"WORLD_WIDTH", 'i', &WORLD_WIDTH, 0},
+        {"WORLD_HEIGHT", 'i', &WORLD_HEIGHT, 0},
+        {"MAX_SPEED", 'd', &MAX_SPEED, 0},
+        {"MAX_ANGVEL", 'd', &MAX_ANGVEL, 0},
+        {"AGENT_SIZE", 'i', &AGENT_SIZE, 1},
+        {"AGENT_AMOUNT", 'i', &AGENT_AMOUNT, 1},
+        {"AGENT_HEALTH", 'i', &AGENT_HEALTH, 1},
+        {"OBSTACLE_SIZE", 'i', &OBSTACLE_SIZE, 1},
+        {"OBSTACLE_SPEED", 'i', &OBSTACLE_SPEED, 1},
+        {"OBSTACLE_COOLDOWN", 'd', &OBSTACLE_COOLDOWN, 1},
+        {"FIRE_COST", 'i', &FIRE_COST},
+        {"HIT_COST", 'i', &HIT_COST},
+        {"HIT_REWARD", 'i', &HIT_REWARD},
+        {"NOVELTY_REWARD", 'd', &NOVELTY_REWARD},
+        {"PROXIMITY_REWARD", 'd', &PROXIMITY_REWARD},
+        {"PROXIMITY_RADIUS", 'd', &PROXIMITY_RADIUS, 1},
+        {"CONTROL_RATE", 'i', &CONTROL_RATE, 1},
+        {"SIGHT_ANGLE", 'i', &SIGHT_ANGLE, 0, 360},
+        {"RAY_AMOUNT", 'i', &RAY_AMOUNT, 1},
+        {"SENSE_CHANNELS", 's', &SENSE_CHANNELS},
+        {"SENSOR_CACHE", 'b', &SENSOR_CACHE},
+        {"SENSOR_TOLERANCE", 'd', &SENSOR_TOLERANCE, 0},
+        {"SENSOR_ANGLE_TOLERANCE", 'd', &SENSOR_ANGLE_TOLERANCE, 0},
+        {"SENSOR_REFRESH", 'i', &SENSOR_REFRESH, 1},
+        {"DEPTH_SENSING", 'b', &DEPTH_SENSING},
+        {"DEBUG", 'b', &DEBUG},
+        {"DEBUG_WIND", 'b', &DEBUG_WIND},
+        {"EPOCH_LENGTH", 'i', &EPOCH_LENGTH, 1},
+        {"EPOCH_AMOUNT", 'i', &EPOCH_AMOUNT, 1},
+        {"MUTATION_AMOUNT", 'd', &MUTATION_AMOUNT, 0},
+        {"MUTATION_CHANCE", 'd', &MUTATION_CHANCE, 0, 1},
+        {"SURVIVOR_REPRODUCTION", 'i', &SURVIVOR_REPRODUCTION, 1},
+        {"MUTATION", 's', &MUTATION},
+        {"CROSSOVER", 's', &CROSSOVER},
+        {"ACTIVATIONS", 's', &ACTIVATIONS},
+        {"FAST_ACTIVATION", 'b', &FAST_ACTIVATION},
+        {"SPARSE", 'b', &SPARSE},
+        {"PRUNE_THRESHOLD", 'd', &PRUNE_THRESHOLD, 0},
+        {"THREADS", 'i', &THREADS, 0},
+        {"TICK_BUDGET", 'd', &TICK_BUDGET, 0},
+        {"METRICS_NAME", 's', &METRICS_NAME},
+        {"METRICS_EVERY", 'i', &METRICS_EVERY, 1},
+        {"INCREMENTAL", 'b', &INCREMENTAL},
+        {"INCREMENTAL_REFRESH", 'i', &INCREMENTAL_REFRESH, 1},
+        {"SHOW_COSTS", 'b', &SHOW_COSTS},
+        {"SHOW_RAYS", 'b', &SHOW_RAYS},
+        {"HEADLESS", 'b', &HEADLESS},
+        {"FIXED_DELTA", 'd', &FIXED_DELTA, 0},
+        {"NETWORK_PATH", 's', &NETWORK_PATH},
+        {"SWEEP_RESULTS", 's', &SWEEP_RESULTS},
+        {"RECORD_PATH", 's', &RECORD_PATH},
+        {"RECORD_EVERY", 'i', &RECORD_EVERY, 1},
+        {"RACE", 'b', &RACE},
+        {"RACE_CANDIDATES", 'i', &RACE_CANDIDATES, 1},
+        {"RACE_LENGTH", 'i', &RACE_LENGTH, 1},
+        {"RACE_KEEP", 'd', &RACE_KEEP, 0, 1},
+        {"RACE_REPEATS", 'i', &RACE_REPEATS, 1},
+        {"RACE_PATIENCE", 'i', &RACE_PATIENCE, 0},
+        {"STEADY_STATE", 'b', &STEADY_STATE},
+        {"STEADY_WORKERS", 'i', &STEADY_WORKERS, 0},
+        {"STEADY_POPULATION", 'i', &STEADY_POPULATION, 0},
+        {"ARCHIVE_PATH", 's', &ARCHIVE_PATH},
+        {"ARCHIVE_ELITES", 'i', &ARCHIVE_ELITES, 0},
+        {"ARCHIVE_SEED", 'i', &ARCHIVE_SEED, 0},
+        {"EVAL_SEED", 'i', &EVAL_SEED},
+        {"EVAL_WORKERS", 'i', &EVAL_WORKERS, 0},
+        {"CHECK_ALLOCATIONS", 'b', &CHECK_ALLOCATIONS},
+        {"ALLOCATION_WARMUP", 'i', &ALLOCATION_WARMUP, 0},
+    };
+}
+
+string trim(string s) {
+    /*
+    Removes whitespace from both ends of a string.
+    */
+    size_t l = s.find_first_not_of(" \t\r\n");
+    if (l == string::npos) return "";
+    size_t r = s.find_last_not_of(" \t\r\n");
+    return s.substr(l, r - l + 1);
+}
+
+bool inBounds(Param p, double v) {
+    /*
+    Checks a number against the bounds of its parameter, saying which
+    values are allowed if it is outside them.
+    */
+    if (v >= p.lo && v <= p.hi) return true;
+    cout << "Invalid config entry: " << p.name << "=" << v << ", has to be ";
+    if (p.hi == HUGE_VAL) cout << "at least " << p.lo << "\n";
+    else cout << "between " << p.lo << " and " << p.hi << "\n";
+    return false;
+}
+
+bool CFGH::set(string key, string value) {
+    /*
+    Sets a parameter from its text value. Numbers have to be parsed
+    completely and lie within the bounds of the parameter table, and sizes
+    is a comma separated list of layer sizes.
+    */
+    value = trim(value);
+    for (Param p : params()) {
+        if (p.name != key) continue;
+        const char* c = value.c_str();
+        char* end;
+        if (p.type == 'i') {
+            long v = strtol(c, &end, 10);
+            if (value == "" || *end != '\0' || v < INT_MIN || v > INT_MAX) break;
+            if (!inBounds(p, v)) return false;
+            *(int*)p.ptr = v;
+        } else if (p.type == 'd') {
+            double v = strtod(c, &end);
+            if (value == "" || *end != '\0') break;
+            if (!inBounds(p, v)) return false;
+            *(double*)p.ptr = v;
+        } else if (p.type == 'b') {
+            if (value == "1" || value == "true") *(bool*)p.ptr = true;
+            else if (value == "0" || value == "false") *(bool*)p.ptr = false;
+            else break;
+        } else if (p.type == 's') {
+            *(string*)p.ptr = value;
+        } else if (p.type == 'v') {
+            vector<int> v;
+            stringstream ss(value);
+            string cur;
+            bool bad = false;
+            while (getline(ss, cur, ',')) {
+                cur = trim(cur);
+                long n = strtol(cur.c_str(), &end, 10);
+                if (cur == "" || *end != '\0' || n < 0) bad = true;
+                v.push_back(n);
+            }
+            if (bad || v.size() < 2) break;
+            // the last layer has no outgoing weights
+            if (v.back() != 0) v.push_back(0);
+            *(vector<int>*)p.ptr = v;
+        }
+        return true;
+    }
+    cout << "Invalid config entry: " << key << "=" << value << "\n";
+    return false;
+}
+
+string CFGH::get(string key) {
+    /*
+    Gets a parameter in the same text format set accepts.
+    */
+    for (Param p : params()) {
+        if (p.name != key) continue;
+        if (p.type == 'i') return to_string(*(int*)p.ptr);
+        if (p.type == 'd') {
+            stringstream ss;
+            ss << *(double*)p.ptr;
+            return ss.str();
+        }
+        if (p.type == 'b') return *(bool*)p.ptr ? "true" : "false";
+        if (p.type == 's') return *(string*)p.ptr;
+        string res = "";
+        for (int n : *(vector<int>*)p.ptr) res += to_string(n) + ",";
+        if (res.size() > 0) res.pop_back();
+        return res;
+    }
+    return "";
+}
+
+bool CFGH::exists(string key) {
+    /*
+    Checks whether a parameter with this name can be set.
+    */
+    for (Param p : params()) {
+        if (p.name == key) return true;
+    }
+    return false;
+}
+
+bool CFGH::load(string path) {
+    /*
+    Reads a config file. Each line is KEY=VALUE, and anything after # is ignored.
+    */
+    ifstream fin(path);
+    if (!fin) {
+        cout << "Config file " << path << " not found\n";
+        return false;
+    }
+    string line;
+    bool ok = true;
+    while (getline(fin, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line == "") continue;
+        size_t eq = line.find('=');
+        if (eq == string::npos) {
+            cout << "Invalid config line: " << line << "\n";
+            ok = false;
+            continue;
+        }
+        ok &= set(trim(line.substr(0, eq)), line.substr(eq + 1));
+    }
+    return ok;
+}
+
+bool CFGH::parseArgs(int argc, char* argv[]) {
+    /*
+    Reads the command line in order: --config PATH loads a file, --sweep PATH
+    selects a grid to sweep over, and KEY=VALUE sets a single parameter.
+    */
+    bool ok = true;
+    for (int i = 1; i < argc; i ++) {
+        string arg = argv[i];
+        if ((arg == "--config" || arg == "--sweep") && i + 1 < argc) {
+            string path = argv[++ i];
+            if (arg == "--config") {
+                ok &= load(path);
+                passed.push_back(arg);
+                passed.push_back(path);
+            } else {
+                sweepPath = path;
+            }
+        } else if (arg.find('=') != string::npos) {
+            size_t eq = arg.find('=');
+            ok &= set(arg.substr(0, eq), arg.substr(eq + 1));
+            passed.push_back(arg);
+        } else {
+            cout << "Unknown argument: " << arg << "\n";
+            ok = false;
+        }
+    }
+    // the input layer has to match the rays of every channel plus speed and angular velocity
+    int channels = 0;
+    stringstream ss(SENSE_CHANNELS);
+    string name;
+    while (getline(ss, name, ',')) {
+        if (name == "") continue;
+        if (name != "agents" && name != "obstacles" && name != "walls") {
+            cout << "Unknown sense channel " << name << "\n";
+            ok = false;
+        }
+        channels ++;
+    }
+    if (sizes[0] != channels * RAY_AMOUNT + 2) {
+        sizes[0] = channels * RAY_AMOUNT + 2;
+        cout << "Input layer resized to " << sizes[0] << " to match RAY_AMOUNT and SENSE_CHANNELS\n";
+    }
+    if (MUTATION != "uniform" && MUTATION != "gaussian") {
+        cout << "Unknown mutation " << MUTATION << "\n";
+        ok = false;
+    }
+    if (CROSSOVER != "none" && CROSSOVER != "uniform" && CROSSOVER != "arithmetic") {
+        cout << "Unknown crossover " << CROSSOVER << "\n";
+        ok = false;
+    }
+    // every layer after the input has a known activation
+    stringstream acts(ACTIVATIONS);
+    while (getline(acts, name, ',')) {
+        if (name == "") continue;
+        if (name != "sigmoid" && name != "tanh" && name != "relu" && name != "hard_sigmoid") {
+            cout << "Unknown activation " << name << "\n";
+            ok = false;
+        }
+    }
+    // steady-state arenas run on their own threads without windows, and the allocation
+    // counter can't tell which of them allocated
+    if (STEADY_STATE) {
+        HEADLESS = true;
+        if (STEADY_WORKERS != 1) CHECK_ALLOCATIONS = false;
+    }
+    // allocations are only counted by programs linked with allocs.o
+    if (CHECK_ALLOCATIONS && !SDLH::allocationsCounted) {
+        cout << "CHECK_ALLOCATIONS needs a program linked with allocs.o, like main\n";
+        ok = false;
+    }
+    if (HEADLESS) {
+        DEBUG_WIND = false;
+        SHOW_RAYS = false;
+    }
+    // rays are drawn while they are cast, which a phased tick does on its threads
+    if (THREADS > 0) SHOW_RAYS = false;
+    return ok;
+}
+
+string CFGH::dump() {
+    /*
+    Writes every parameter in a format load can read back.
+    */
+    string res = "";
+    for (Param p : params()) {
+        res += p.name + "=" + get(p.name) + "\n";
+    }
+    return res;
+}
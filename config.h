@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "constants.h"
+
+namespace CFGH {
+    bool set(std::string key, std::string value); // set one parameter by name. false if unknown or malformed
+    std::string get(std::string key); // get one parameter as text
+    bool exists(std::string key); // whether a parameter with this name exists
+    bool load(std::string path); // read KEY=VALUE lines from a file, # starts a comment
+    bool parseArgs(int argc, char* argv[]); // applies --config files, KEY=VALUE overrides and --sweep
+    std::string dump(); // all parameters as KEY=VALUE lines
+
+    extern std::string sweepPath; // grid file given with --sweep, empty if not sweeping
+    extern std::vector<std::string> passed; // arguments other than --sweep, handed down to sweep runs
+
+    struct SweepRun { // one point of a parameter grid
+        std::vector<std::pair<std::string, std::string>> values; // swept parameters and their values
+        bool ok; // whether the run finished and reported a result
+        double best; // minimum cost of the last epoch
+        double mean; // minimum cost averaged over all epochs
+    };
+
+    std::vector<SweepRun> expand(std::string path); // read a grid file of KEY=v1,v2,... lines into every combination
+    std::vector<SweepRun> sweep(std::string path, std::string exe); // run every combination headless, one process per core
+    void report(std::vector<SweepRun> runs, std::string path=""); // print results as a table and optionally save them as csv
+}
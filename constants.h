@@ -5,46 +5,101 @@
 #include <random>
 #include <vector>
 
+// Parameters below are loaded at startup and can be changed with a config file
+// or KEY=VALUE arguments (see config.h). Their defaults are set in config.cpp.
+
 // sizes of different layers
-// const std::vector<int> sizes = {26, 7, 7, 3, 0};
-const std::vector<int> sizes = {52, 7, 3, 0};
-
-const int WINDOW_SIZE = 750;
-
-const double MAX_SPEED = 0.75;
-const double MAX_ANGVEL = 4;
-const int AGENT_SIZE = 15;
-// const int AGENT_AMOUNT = 30;
-const int AGENT_AMOUNT = 10;
-const int AGENT_HEALTH = 1;
-
-const int OBSTACLE_SIZE = 10;
-const int OBSTACLE_SPEED = 3;
-const double OBSTACLE_COOLDOWN = 250;
-const int FIRE_COST = 20;
-const int HIT_COST = 125;
-const int HIT_REWARD = -200; // reward to hitting another agent
-const double NOVELTY_REWARD = 1;
-const double PROXIMITY_REWARD = 7; // reward for getting close to another agent
-const double PROXIMITY_RADIUS = 75;
-
-const int SIGHT_ANGLE = 100; // angle that the agent can see using rays
-const int RAY_AMOUNT = 50; // amount of rays sent out
-
-const bool DEBUG = false; // prints out debug statements
-const bool DEBUG_WIND = true; // shows neural network in new window
+// {26, 7, 7, 3, 0};
+extern std::vector<int> sizes;
+
+extern int WINDOW_SIZE;
+extern int WORLD_WIDTH; // size of the world agents move in, 0 to use WINDOW_SIZE
+extern int WORLD_HEIGHT;
+
+extern double MAX_SPEED;
+extern double MAX_ANGVEL;
+extern int AGENT_SIZE;
+extern int AGENT_AMOUNT;
+extern int AGENT_HEALTH;
+
+extern int OBSTACLE_SIZE;
+extern int OBSTACLE_SPEED;
+extern double OBSTACLE_COOLDOWN;
+extern int FIRE_COST;
+extern int HIT_COST;
+extern int HIT_REWARD; // reward to hitting another agent
+extern double NOVELTY_REWARD;
+extern double PROXIMITY_REWARD; // reward for getting close to another agent
+extern double PROXIMITY_RADIUS;
+
+extern int CONTROL_RATE; // ticks between network evaluations, the last action is repeated in between
+
+extern int SIGHT_ANGLE; // angle that the agent can see using rays
+extern int RAY_AMOUNT; // amount of rays sent out
+extern std::string SENSE_CHANNELS; // what the rays see, any of agents, obstacles and walls. Each adds RAY_AMOUNT inputs
+
+extern bool SENSOR_CACHE; // reuse ray readings when nothing in view has moved
+extern double SENSOR_TOLERANCE; // error budget: movement in pixels ignored by the sensor cache
+extern double SENSOR_ANGLE_TOLERANCE; // error budget: turning in degrees ignored by the sensor cache
+extern int SENSOR_REFRESH; // ticks a cached ray reading can be reused before it is recast
+extern bool DEPTH_SENSING; // project each agent and obstacle once onto the rays it covers instead of testing every ray
+
+extern bool DEBUG; // prints out debug statements
+extern bool DEBUG_WIND; // shows neural network in new window
 const int DEBUG_SIZE = 700;
 const int YOFF = 375; // how much to move the representation down
 const int NSIZE = 15; // how large the node representation is
 const int XGAP = 150; // the gap between nodes in the window
 const int YGAP = 75;
 
-const int EPOCH_LENGTH = 800;
-const int EPOCH_AMOUNT = 50;
+extern int EPOCH_LENGTH;
+extern int EPOCH_AMOUNT;
+
+extern double MUTATION_AMOUNT;
+extern double MUTATION_CHANCE;
+extern int SURVIVOR_REPRODUCTION;
+extern std::string MUTATION; // uniform adds noise up to MUTATION_AMOUNT, gaussian scales normal noise by how much the survivors differ
+extern std::string CROSSOVER; // none, uniform or arithmetic crossover between two survivors before mutating
+
+extern std::string ACTIVATIONS; // activation of each layer after the input, the last one repeats
+extern bool FAST_ACTIVATION; // use the vectorizable approximations of sigmoid and tanh
+
+extern bool SPARSE; // prune networks and run them as sparse rows
+extern double PRUNE_THRESHOLD; // weights smaller than this in magnitude are pruned from sparse networks
+extern int THREADS; // threads each tick is split over in phases, 0 updates agents one after another
+extern double TICK_BUDGET; // milliseconds a tick of a live display should take, quality is lowered in steps while ticks take longer
+extern std::string METRICS_NAME; // shared memory segment live metrics are published to, see metrics.h, none if empty
+extern int METRICS_EVERY; // ticks between publishing metrics
+extern bool INCREMENTAL; // run the first hidden layer from the change in inputs since the last run
+extern int INCREMENTAL_REFRESH; // runs between recomputing the incremental sums from scratch
+
+extern bool SHOW_COSTS; // show costs of agents based on their colors
+extern bool SHOW_RAYS; // show rays of agents and what they hit
+
+extern bool HEADLESS; // run without windows or rendering
+extern double FIXED_DELTA; // if above 0, every tick advances this much instead of using the real time elapsed
+extern std::string NETWORK_PATH; // where the best network is stored, nothing is stored if empty
+extern std::string SWEEP_RESULTS; // where the table of a parameter sweep is written
+extern std::string RECORD_PATH; // where a replay of the run is recorded, nothing is recorded if empty
+extern int RECORD_EVERY; // only every this many epochs are recorded
+
+extern bool RACE; // pick survivors by successive halving instead of one episode of every agent
+extern int RACE_CANDIDATES; // networks bred each epoch when racing
+extern int RACE_LENGTH; // ticks of the first round's episodes, doubled every round
+extern double RACE_KEEP; // fraction of candidates that go on to the next round
+extern int RACE_REPEATS; // full episodes each finalist plays
+extern int RACE_PATIENCE; // ticks the cost ranking has to stay the same to end a race episode early, 0 never does
+
+extern bool STEADY_STATE; // evolve without epochs, breeding each arena from the survivors of all finished ones
+extern int STEADY_WORKERS; // threads running arenas side by side in steady-state evolution, 0 uses one per core
+extern int STEADY_POPULATION; // survivors kept to breed from in steady-state evolution, 0 keeps AGENT_AMOUNT
+
+extern std::string ARCHIVE_PATH; // hall of fame file the best networks of every run are added to, none if empty
+extern int ARCHIVE_ELITES; // best survivors of each epoch added to the archive
+extern int ARCHIVE_SEED; // best networks of the archive the first epoch is bred from, 0 starts from random ones
 
-const double MUTATION_AMOUNT = 0.4;
-const double MUTATION_CHANCE = 0.8;
-const int SURVIVOR_REPRODUCTION = 2;
+extern int EVAL_SEED; // seed of the first episode of an evaluation, the next ones count up from it
+extern int EVAL_WORKERS; // threads running evaluation episodes, 0 uses one per core
 
-const bool SHOW_COSTS = true; // show costs of agents based on their colors
-const bool SHOW_RAYS = false; // show rays of agents and what they hit
\ No newline at end of file
+extern bool CHECK_ALLOCATIONS; // stop with an error if a tick allocates heap memory after warming up
+extern int ALLOCATION_WARMUP; // ticks of each epoch that may still allocate
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "env.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+Env
+*/
+
+SDLH::Env::Env(int n) {
+    /*
+    Constructor for Env. Every arena is a headless Display with a fixed tick
+    length, so stepping it only depends on the actions and the seeds.
+    */
+    this->n = n;
+    agents = AGENT_AMOUNT;
+    obsSize = sizes[0];
+    steps = 0;
+    for (int k = 0; k < n; k ++) {
+        Display* b = new Display(WINDOW_SIZE, WINDOW_SIZE);
+        b->headless = true;
+        b->step = FIXED_DELTA > 0 ? FIXED_DELTA : 1;
+        b->reserve();
+        for (int j = 0; j < agents; j ++) {
+            Agent* a = new Agent(0, 0, 0, 0, b);
+            a->external = true;
+            a->action = {0, 0.5, 0};
+            slots.push_back(a);
+        }
+        arenas.push_back(b);
+    }
+    obs = vector<double> (n * agents * obsSize, 0);
+    costs = vector<double> (n * agents, 0);
+    done = vector<unsigned char> (n * agents, 0);
+    before = vector<double> (n * agents, 0);
+    observed = vector<real> (obsSize, 0);
+}
+
+SDLH::Env::~Env() {
+    /*
+    Destructor for Env.
+    */
+    for (Agent* a : slots) delete a;
+    for (Display* b : arenas) delete b;
+}
+
+void SDLH::Env::reset(const vector<unsigned int>& seeds) {
+    /*
+    Clears every arena and respawns its agents at positions drawn from its
+    seed, then gathers the first observations.
+    */
+    uniform_real_distribution<double> dist2(0.0, 359.0);
+    for (int k = 0; k < n; k ++) {
+        mt19937 mt(seeds[k]);
+        Display* b = arenas[k];
+        uniform_int_distribution<int> distx(0, b->worldWidth);
+        uniform_int_distribution<int> disty(0, b->worldHeight);
+        b->clearAgents();
+        b->clearObstacles();
+        b->ticks = 0;
+        for (int j = 0; j < agents; j ++) {
+            Agent* a = slots[k * agents + j];
+            int x = distx(mt), y = disty(mt);
+            a->respawn(x, y, dist2(mt));
+            a->action = {0, 0.5, 0};
+            b->addAgent(a);
+        }
+    }
+    steps = 0;
+    gather();
+    fill(costs.begin(), costs.end(), 0);
+}
+
+void SDLH::Env::step(const double* actions) {
+    /*
+    Sets the action of every living agent and advances each arena that isn't
+    done by one tick, including the novelty and proximity rewards.
+    Actions are in the range of the network outputs: speed, turning and
+    firing, each between 0 and 1.
+    */
+    for (int i = 0; i < n * agents; i ++) {
+        Agent* a = slots[i];
+        before[i] = a->cost;
+        for (int c = 0; c < 3; c ++) a->action[c] = actions[i * 3 + c];
+    }
+    for (int k = 0; k < n; k ++) {
+        Display* b = arenas[k];
+        if (b->getAgents().empty() || b->ticks >= EPOCH_LENGTH) continue;
+        b->loop();
+        b->reward();
+    }
+    steps ++;
+    gather();
+}
+
+void SDLH::Env::gather() {
+    /*
+    Writes the observations, cost changes and done flags of every agent into
+    the output buffers. Dead agents observe nothing. Agents observe in the
+    precision of the build (see precision.h) and the buffers stay double.
+    */
+    for (int k = 0; k < n; k ++) {
+        Display* b = arenas[k];
+        bool over = b->getAgents().empty() || b->ticks >= EPOCH_LENGTH;
+        for (int j = 0; j < agents; j ++) {
+            int i = k * agents + j;
+            Agent* a = slots[i];
+            bool dead = a->health <= 0;
+            if (dead) {
+                fill(obs.begin() + i * obsSize, obs.begin() + (i + 1) * obsSize, 0);
+            } else {
+                a->observe(b, observed.data());
+                copy(observed.begin(), observed.end(), obs.begin() + i * obsSize);
+            }
+            costs[i] = a->cost - before[i];
+            done[i] = dead || over;
+        }
+    }
+}
+
+void SDLH::Env::infer(double* actions) {
+    /*
+    Runs every living agent's network on its current observation and writes
+    its outputs as the agent's next action.
+    */
+    for (int i = 0; i < n * agents; i ++) {
+        Agent* a = slots[i];
+        if (a->health <= 0) {
+            fill(actions + i * 3, actions + i * 3 + 3, 0);
+            continue;
+        }
+        AIH::Layer* inp = a->nn->layers[0];
+        for (int v = 0; v < obsSize; v ++) {
+            inp->neurons[v]->value = obs[i * obsSize + v];
+        }
+        const vector<real>& out = a->nn->run();
+        for (int c = 0; c < 3; c ++) actions[i * 3 + c] = out[c];
+    }
+}
+
+/*
+C interface
+*/
+
+void* env_create(int n) {
+    return new SDLH::Env(n);
+}
+
+void env_destroy(void* env) {
+    delete (SDLH::Env*)env;
+}
+
+void env_reset(void* env, const unsigned int* seeds) {
+    SDLH::Env* e = (SDLH::Env*)env;
+    e->reset(vector<unsigned int> (seeds, seeds + e->n));
+}
+
+void env_step(void* env, const double* actions) {
+    ((SDLH::Env*)env)->step(actions);
+}
+
+void env_infer(void* env, double* actions) {
+    ((SDLH::Env*)env)->infer(actions);
+}
+
+int env_agents(void* env) {
+    return ((SDLH::Env*)env)->agents;
+}
+
+int env_observation_size(void* env) {
+    return ((SDLH::Env*)env)->obsSize;
+}
+
+const double* env_observations(void* env) {
+    return ((SDLH::Env*)env)->obs.data();
+}
+
+const double* env_costs(void* env) {
+    return ((SDLH::Env*)env)->costs.data();
+}
+
+const unsigned char* env_done(void* env) {
+    return ((SDLH::Env*)env)->done.data();
+}
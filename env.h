@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "sdl.h"
+#include "constants.h"
+
+namespace SDLH {
+    class Env { // steps many headless arenas in lockstep for an outside controller
+        public:
+            Env(int n); // constructor, makes n arenas of AGENT_AMOUNT agents
+            ~Env(); // destructor, frees the arenas and their agents
+            void reset(const std::vector<unsigned int>& seeds); // respawn every arena, seeds[k] places arena k's agents
+            void step(const double* actions); // apply n * agents * 3 actions and advance every arena by one tick
+            void infer(double* actions); // fill actions by running each agent's own network on its observation
+            void gather(); // refill obs, costs and done from the arenas
+
+            int n; // amount of arenas
+            int agents; // agents per arena
+            int obsSize; // values per observation, the size of the network's input layer
+            long long steps; // ticks taken since the last reset
+            // outputs, agent j of arena k is at index k * agents + j
+            std::vector<double> obs; // observations, obsSize values per agent
+            std::vector<double> costs; // change in cost of each agent during the last step
+            std::vector<unsigned char> done; // 1 if the agent is dead or its arena has run EPOCH_LENGTH ticks
+
+            std::vector<Display*> arenas;
+            std::vector<Agent*> slots; // every agent, including dead ones, in the same order as the outputs
+        private:
+            std::vector<double> before; // cost of each agent before the last step
+            std::vector<real> observed; // one observation before it is copied into obs
+    };
+};
+
+// Thin C interface around Env, so controllers outside of C++ can drive it.
+// Buffers returned stay valid until the env is destroyed.
+extern "C" {
+    void* env_create(int n);
+    void env_destroy(void* env);
+    void env_reset(void* env, const unsigned int* seeds); // n seeds
+    void env_step(void* env, const double* actions); // n * agents * 3 actions
+    void env_infer(void* env, double* actions); // actions from the agents' own networks
+    int env_agents(void* env);
+    int env_observation_size(void* env);
+    const double* env_observations(void* env);
+    const double* env_costs(void* env);
+    const unsigned char* env_done(void* env);
+}
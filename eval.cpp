@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+#include "evaluate.h"
+#include "ai.h"
+#include "config.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+Re-runs stored networks to measure how good they are, without evolving them.
+
+    ./eval MODE EPISODES NETWORK [NETWORK ...] [KEY=VALUE ...]
+
+MODE is alone, mixed or roundrobin (see SDLH::schedule). Every network plays
+EPISODES seeded episodes of EPOCH_LENGTH ticks in that mode, spread over
+EVAL_WORKERS threads, and the mean and variance of its cost and of every
+part of the cost are printed. The same EVAL_SEED gives the same results, so
+two builds or two networks can be compared episode for episode. Pass the
+parameters the networks were trained with.
+*/
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cout << "Usage: ./eval alone|mixed|roundrobin EPISODES NETWORK [NETWORK ...] [KEY=VALUE ...]\n";
+        return 1;
+    }
+    string mode = argv[1];
+    int episodes = stoi(argv[2]);
+    vector<string> paths;
+    vector<char*> rest = {argv[0], (char*)"HEADLESS=true"};
+    for (int i = 3; i < argc; i ++) {
+        if (string(argv[i]).find('=') != string::npos) {
+            rest.push_back(argv[i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (!CFGH::parseArgs(rest.size(), rest.data())) {
+        return 1;
+    }
+    if (mode != "alone" && mode != "mixed" && mode != "roundrobin") {
+        cout << "Unknown mode " << mode << "\n";
+        return 1;
+    }
+    if (mode == "roundrobin" && paths.size() < 2) {
+        cout << "A round robin needs at least two networks\n";
+        return 1;
+    }
+    vector<string> stored;
+    for (string& path : paths) {
+        ifstream fin(path);
+        string s;
+        fin >> s;
+        vector<double> vals;
+        bool sparse;
+        if (!AIH::parseNetwork(s, vals, sparse)) {
+            cout << path << " doesn't hold a network of the given sizes\n";
+            return 1;
+        }
+        stored.push_back(s);
+    }
+
+    vector<SDLH::Matchup> games = SDLH::schedule(mode, stored.size(), episodes);
+    vector<SDLH::EvalStats> pairs;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<SDLH::EvalStats> stats = SDLH::evaluate(stored, games, &pairs);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << games.size() << " episodes in " << seconds << "s\n";
+
+    cout << fixed << setprecision(3);
+    for (int i = 0; i < (int)stats.size(); i ++) {
+        SDLH::EvalStats& s = stats[i];
+        cout << paths[i] << ": " << s.samples << " agents\n";
+        cout << "  cost " << s.mean[0] << " (variance " << s.variance(0) << ", standard error " << sqrt(s.variance(0) / max(s.samples, 1LL)) << ")\n";
+        for (int k = 0; k < SDLH::COST_PARTS; k ++) {
+            cout << "  " << SDLH::costPartName(k) << " " << s.mean[k + 1] << " (variance " << s.variance(k + 1) << ")\n";
+        }
+    }
+    if (mode == "roundrobin") {
+        // mean cost of the row's agents in arenas shared with the column's
+        cout << "Mean cost against each other network:\n";
+        for (int i = 0; i < (int)stats.size(); i ++) {
+            cout << "  " << i;
+            for (int j = 0; j < (int)stats.size(); j ++) {
+                if (i == j) {
+                    cout << "        -";
+                } else {
+                    cout << " " << setw(8) << pairs[i * stats.size() + j].mean[0];
+                }
+            }
+            cout << "\n";
+        }
+    }
+    return 0;
+}
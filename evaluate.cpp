@@ -0,0 +1,144 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include "evaluate.h"
+#include "race.h"
+#include "ai.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+EvalStats
+*/
+
+SDLH::EvalStats::EvalStats() {
+    samples = 0;
+    fill(mean, mean + COST_PARTS + 1, 0);
+    fill(m2, m2 + COST_PARTS + 1, 0);
+}
+
+void SDLH::EvalStats::add(const double* values) {
+    /*
+    Welford's update, which doesn't lose precision the way summing squares
+    does when the variance is small next to the mean.
+    */
+    samples ++;
+    for (int k = 0; k <= COST_PARTS; k ++) {
+        double d = values[k] - mean[k];
+        mean[k] += d / samples;
+        m2[k] += d * (values[k] - mean[k]);
+    }
+}
+
+double SDLH::EvalStats::variance(int k) {
+    return samples > 1 ? m2[k] / (samples - 1) : 0;
+}
+
+/*
+Evaluation
+*/
+
+vector<SDLH::Matchup> SDLH::schedule(string mode, int networks, int episodes) {
+    /*
+    Mixed arenas hand the networks out in turns starting from a different
+    one each episode, so that none is always the first to spawn.
+    */
+    vector<Matchup> games;
+    for (int e = 0; e < episodes; e ++) {
+        unsigned int seed = EVAL_SEED + e;
+        if (mode == "alone") {
+            for (int i = 0; i < networks; i ++) games.push_back({{i}, seed});
+        } else if (mode == "mixed") {
+            Matchup g = {{}, seed};
+            for (int j = 0; j < AGENT_AMOUNT; j ++) g.nets.push_back((e + j) % networks);
+            games.push_back(g);
+        } else if (mode == "roundrobin") {
+            for (int i = 0; i < networks; i ++) {
+                for (int k = i + 1; k < networks; k ++) {
+                    Matchup g = {{}, seed};
+                    for (int j = 0; j < AGENT_AMOUNT; j ++) g.nets.push_back(j % 2 == 0 ? i : k);
+                    games.push_back(g);
+                }
+            }
+        }
+    }
+    return games;
+}
+
+vector<SDLH::EvalStats> SDLH::evaluate(const vector<string>& stored, const vector<Matchup>& games, vector<EvalStats>* pairs) {
+    /*
+    Threads take the next matchup from a shared counter and write the cost
+    of each of its agents to that matchup's own slot, and the slots are
+    added up in order once every thread is done, so the sums come out the
+    same for any amount of threads.
+    */
+    int networks = stored.size();
+    for (const string& s : stored) {
+        vector<double> vals;
+        bool sparse;
+        if (!AIH::parseNetwork(s, vals, sparse)) return {};
+    }
+    int workers = EVAL_WORKERS > 0 ? EVAL_WORKERS : max((int)thread::hardware_concurrency(), 1);
+    vector<vector<double>> results(games.size());
+    atomic<int> next(0);
+    prepareShared();
+
+    auto play = [&] () {
+        Display* b = makeArena();
+        b->step = FIXED_DELTA > 0 ? FIXED_DELTA : 1;
+        vector<Agent*> agents;
+        for (int g = next ++; g < (int)games.size(); g = next ++) {
+            const Matchup& m = games[g];
+            mt19937 mt(m.seed);
+            b->clearAgents();
+            b->clearObstacles();
+            b->ticks = 0;
+            agents.clear();
+            for (int i : m.nets) {
+                agents.push_back(spawnAgent(b, new AIH::Network(stored[i]), mt));
+            }
+            runEpisode(b, EPOCH_LENGTH, NULL, false);
+            vector<double>& r = results[g];
+            for (Agent* a : agents) {
+                r.push_back(a->cost);
+                r.insert(r.end(), a->parts, a->parts + COST_PARTS);
+                delete a;
+            }
+        }
+        b->clearAgents();
+        b->clearObstacles();
+        delete b;
+    };
+    vector<thread> threads;
+    for (int w = 1; w < workers; w ++) threads.push_back(thread(play));
+    play();
+    for (thread& t : threads) t.join();
+
+    vector<EvalStats> stats(networks);
+    if (pairs != NULL) pairs->assign(networks * networks, EvalStats());
+    for (int g = 0; g < (int)games.size(); g ++) {
+        const vector<int>& nets = games[g].nets;
+        // the two networks of a round robin matchup, if that's what it is
+        int first = nets[0], second = -1;
+        for (int i : nets) {
+            if (i != first && second == -1) second = i;
+            if (i != first && i != second) first = -1;
+        }
+        for (int j = 0; j < (int)nets.size(); j ++) {
+            const double* values = results[g].data() + j * (COST_PARTS + 1);
+            stats[nets[j]].add(values);
+            if (pairs != NULL && first >= 0 && second >= 0) {
+                int other = nets[j] == first ? second : first;
+                (*pairs)[nets[j] * networks + other].add(values);
+            }
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "sdl.h"
+
+/*
+Evaluation of stored networks without evolving them: a list of seeded
+episodes is spread over threads, each with a headless display of its own,
+and the cost of every agent is collected by network. Episodes are seeded
+and tick by a fixed step, so the results don't depend on how many threads
+ran them.
+*/
+
+namespace SDLH {
+    struct Matchup { // one episode: which network each agent runs and where they spawn
+        std::vector<int> nets; // index of the network of every agent
+        unsigned int seed; // places the agents
+    };
+
+    struct EvalStats { // running mean and variance of an agent's cost and its parts, over episodes
+        EvalStats();
+        void add(const double* values); // COST_PARTS + 1 values: the cost, then each part
+        double variance(int k); // sample variance of value k
+
+        long long samples;
+        double mean[COST_PARTS + 1];
+        double m2[COST_PARTS + 1]; // summed squared differences from the mean
+    };
+
+    // Matchups of the networks for a mode: "alone" plays each network on its
+    // own, "mixed" fills every arena with all of them in turns, and
+    // "roundrobin" has every pair share arenas half and half. Each has
+    // episodes seeded EVAL_SEED, EVAL_SEED + 1 and so on, so every network
+    // meets the same spawns.
+    std::vector<Matchup> schedule(std::string mode, int networks, int episodes);
+
+    // Runs every matchup for EPOCH_LENGTH ticks over EVAL_WORKERS threads and
+    // returns the statistics of each network. If pairs isn't NULL it also
+    // gets those of network i against network j at i * networks + j, for the
+    // matchups with two networks. Returns nothing if a stored network doesn't
+    // fit sizes.
+    std::vector<EvalStats> evaluate(const std::vector<std::string>& stored, const std::vector<Matchup>& games, std::vector<EvalStats>* pairs=NULL);
+};
@@ -0,0 +1,203 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "genetic.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+Rng
+*/
+
+AIH::Rng::Rng(uint64_t seed) {
+    /*
+    Constructor for Rng. Every lane gets its own state from splitmix64, so
+    the lanes are independent streams.
+    */
+    auto split = [&seed] () {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+    for (int l = 0; l < RNG_LANES; l ++) {
+        s0[l] = split();
+        s1[l] = split();
+        s2[l] = split();
+        s3[l] = split();
+    }
+}
+
+void AIH::Rng::next(double* out, int blocks) {
+    /*
+    Advances every lane once per block. The lanes don't depend on each other,
+    so the inner loop becomes SIMD instructions (this file is built with
+    VECFLAGS). The state is copied into locals so it stays in registers.
+    */
+    uint64_t a[RNG_LANES], b[RNG_LANES], c[RNG_LANES], d[RNG_LANES];
+    copy(s0, s0 + RNG_LANES, a);
+    copy(s1, s1 + RNG_LANES, b);
+    copy(s2, s2 + RNG_LANES, c);
+    copy(s3, s3 + RNG_LANES, d);
+    for (int k = 0; k < blocks; k ++) {
+        for (int l = 0; l < RNG_LANES; l ++) {
+            uint64_t res = a[l] + d[l];
+            uint64_t t = b[l] << 17;
+            c[l] ^= a[l];
+            d[l] ^= b[l];
+            b[l] ^= c[l];
+            a[l] ^= d[l];
+            c[l] ^= t;
+            d[l] = (d[l] << 45) | (d[l] >> 19);
+            // the top 53 bits as a double in [0, 1)
+            out[k * RNG_LANES + l] = (double)(res >> 11) * (1.0 / 9007199254740992.0);
+        }
+    }
+    copy(a, a + RNG_LANES, s0);
+    copy(b, b + RNG_LANES, s1);
+    copy(c, c + RNG_LANES, s2);
+    copy(d, d + RNG_LANES, s3);
+}
+
+void AIH::Rng::uniform(double* out, int n, double lo, double hi) {
+    /*
+    Whole blocks are written straight into out, the rest through a buffer.
+    */
+    int full = n / RNG_LANES;
+    next(out, full);
+    for (int i = 0; i < full * RNG_LANES; i ++) out[i] = lo + (hi - lo) * out[i];
+    if (full * RNG_LANES < n) {
+        double block[RNG_LANES];
+        next(block, 1);
+        for (int i = full * RNG_LANES; i < n; i ++) out[i] = lo + (hi - lo) * block[i - full * RNG_LANES];
+    }
+}
+
+void AIH::Rng::normal(double* out, int n) {
+    /*
+    The sum of four uniform values, rescaled to a variance of 1. It is close
+    to a normal distribution except that it stops at 3.5 standard deviations,
+    which mutation doesn't miss, and it needs no logarithms or cosines.
+    */
+    vector<double> u(4 * n);
+    uniform(u.data(), u.size(), 0, 1);
+    for (int i = 0; i < n; i ++) {
+        out[i] = (u[i] + u[n + i] + u[2 * n + i] + u[3 * n + i] - 2) * sqrt(3.0);
+    }
+}
+
+AIH::Rng& AIH::rng() {
+    static Rng shared(random_device{}());
+    return shared;
+}
+
+/*
+Operators
+*/
+
+void AIH::mutateUniform(double* p, int n, double amount, Rng& r) {
+    vector<double> noise(n);
+    r.uniform(noise.data(), n, -amount, amount);
+    for (int i = 0; i < n; i ++) p[i] += noise[i];
+}
+
+void AIH::mutateGaussian(double* p, const double* steps, int size, int count, Rng& r) {
+    /*
+    Every genome in the batch uses the same step size for a parameter.
+    */
+    vector<double> noise(size * count);
+    r.normal(noise.data(), noise.size());
+    for (int c = 0; c < count; c ++) {
+        double* g = p + c * size;
+        const double* z = noise.data() + c * size;
+        for (int i = 0; i < size; i ++) g[i] += steps[i] * z[i];
+    }
+}
+
+void AIH::crossUniform(const double* a, const double* b, double* child, int size, Rng& r) {
+    vector<double> pick(size);
+    r.uniform(pick.data(), size, 0, 1);
+    for (int i = 0; i < size; i ++) child[i] = pick[i] < 0.5 ? a[i] : b[i];
+}
+
+void AIH::crossArithmetic(const double* a, const double* b, double* child, int size, Rng& r) {
+    double w;
+    r.uniform(&w, 1, 0, 1);
+    for (int i = 0; i < size; i ++) child[i] = w * a[i] + (1 - w) * b[i];
+}
+
+void AIH::clamp(double* p, int n, double limit) {
+    for (int i = 0; i < n; i ++) p[i] = min(max(p[i], -limit), limit);
+}
+
+vector<double> AIH::spread(const double* parents, int size, int count) {
+    /*
+    Standard deviation of each parameter over count genomes.
+    */
+    vector<double> mean(size, 0), var(size, 0);
+    for (int c = 0; c < count; c ++) {
+        for (int i = 0; i < size; i ++) mean[i] += parents[c * size + i] / count;
+    }
+    for (int c = 0; c < count; c ++) {
+        for (int i = 0; i < size; i ++) {
+            double d = parents[c * size + i] - mean[i];
+            var[i] += d * d / count;
+        }
+    }
+    for (int i = 0; i < size; i ++) var[i] = sqrt(var[i]);
+    return var;
+}
+
+void AIH::breed(vector<Network*>& nets, int children, int parents, double amount, Rng& r) {
+    /*
+    Children are crossed with two random parents if CROSSOVER is set, then
+    mutated. With MUTATION=gaussian the step size of each parameter is the
+    spread of that parameter among the parents, kept between a tenth of
+    amount and amount: parameters the parents agree on are searched finely
+    and the ones they disagree on broadly. A single parent has no spread to
+    go by, so every step is amount. Sparse networks keep their pruned
+    connections pruned, since Network::scatter skips them.
+    */
+    children = min(children, (int)nets.size());
+    parents = min(parents, (int)nets.size());
+    if (children <= 0) return;
+    int size = nets[0]->parameters();
+    vector<double> kids(size * children), mums(size * max(parents, 1));
+    for (int c = 0; c < parents; c ++) nets[c]->gather(mums.data() + c * size);
+    for (int c = 0; c < children; c ++) nets[c]->gather(kids.data() + c * size);
+
+    if (CROSSOVER != "none" && parents >= 2) {
+        vector<double> picks(2 * children);
+        r.uniform(picks.data(), picks.size(), 0, parents);
+        for (int c = 0; c < children; c ++) {
+            const double* a = mums.data() + (int)picks[2 * c] * size;
+            const double* b = mums.data() + (int)picks[2 * c + 1] * size;
+            if (CROSSOVER == "arithmetic") {
+                crossArithmetic(a, b, kids.data() + c * size, size, r);
+            } else {
+                crossUniform(a, b, kids.data() + c * size, size, r);
+            }
+        }
+    }
+
+    if (MUTATION == "gaussian") {
+        vector<double> steps(size, amount);
+        if (parents >= 2) {
+            steps = spread(mums.data(), size, parents);
+            for (double& s : steps) s = min(max(s, 0.1 * amount), amount);
+        }
+        mutateGaussian(kids.data(), steps.data(), size, children, r);
+    } else {
+        mutateUniform(kids.data(), kids.size(), amount, r);
+    }
+    clamp(kids.data(), kids.size(), 5);
+
+    for (int c = 0; c < children; c ++) {
+        nets[c]->scatter(kids.data() + c * size);
+        if (nets[c]->sparse) nets[c]->prune(PRUNE_THRESHOLD);
+    }
+}
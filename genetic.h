@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "ai.h"
+
+/*
+Genetic operators that work on networks flattened into contiguous buffers
+(see Network::gather), one genome after another, so every operator is one
+loop over a whole batch of offspring that the compiler can vectorize.
+*/
+
+namespace AIH {
+    const int RNG_LANES = 8; // independent generators advanced side by side
+
+    class Rng { // xoshiro256+ with its state split into lanes so blocks of numbers are made in parallel
+        public:
+            Rng(uint64_t seed);
+            void uniform(double* out, int n, double lo, double hi); // n values evenly spread in [lo, hi)
+            void normal(double* out, int n); // n roughly standard normal values, see genetic.cpp
+        private:
+            void next(double* out, int blocks); // the next blocks values of every lane, in [0, 1)
+
+            uint64_t s0[RNG_LANES], s1[RNG_LANES], s2[RNG_LANES], s3[RNG_LANES];
+    };
+
+    Rng& rng(); // generator shared by mutation and breeding, seeded from std::random_device
+
+    void mutateUniform(double* p, int n, double amount, Rng& r); // add noise in [-amount, amount] to n values
+    void mutateGaussian(double* p, const double* steps, int size, int count, Rng& r); // add normal noise scaled per parameter
+    void crossUniform(const double* a, const double* b, double* child, int size, Rng& r); // each parameter from either parent
+    void crossArithmetic(const double* a, const double* b, double* child, int size, Rng& r); // a random blend of both parents
+    void clamp(double* p, int n, double limit); // keep values in [-limit, limit]
+    std::vector<double> spread(const double* parents, int size, int count); // standard deviation of each parameter
+
+    // Mutates nets[0] to nets[children - 1] in one batch according to MUTATION
+    // and CROSSOVER. The first parents networks are the parents crossover
+    // picks from and whose spread sets the adaptive step sizes, which are
+    // amount with fewer than two of them (as for Network::mutate). Threads
+    // breeding at the same time each need their own r.
+    void breed(std::vector<Network*>& nets, int children, int parents, double amount, Rng& r = rng());
+}
@@ -5,113 +5,170 @@
 
 #include "sdl.h"
 #include "ai.h"
+#include "config.h"
+#include "replay.h"
+#include "race.h"
+#include "genetic.h"
+#include "metrics.h"
+#include "steady.h"
+#include "archive.h"
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (!CFGH::parseArgs(argc, argv)) {
+        return 1;
+    }
+    if (CFGH::sweepPath != "") {
+        // run the grid as separate processes of this program
+        CFGH::report(CFGH::sweep(CFGH::sweepPath, argv[0]), SWEEP_RESULTS);
+        return 0;
+    }
+
     SDLH::Display* b = new SDLH::Display(WINDOW_SIZE, WINDOW_SIZE);
+    b->reserve();
+    SDLH::Recorder* recorder = NULL;
+    if (RECORD_PATH != "") {
+        recorder = new SDLH::Recorder(RECORD_PATH, b);
+    }
+    if (METRICS_NAME != "") {
+        b->metrics = new SDLH::Metrics(METRICS_NAME);
+    }
 
-    b->createDebug();
+    if (!HEADLESS) {
+        b->createDebug();
 
-    b->initBasics();
+        b->initBasics();
+    }
 
     std::random_device rd;
     std::mt19937 mt(rd());
-    std::uniform_real_distribution<double> dist2(0.0, 359.0);
-    std::uniform_int_distribution<int> dist(0, WINDOW_SIZE);
     
     vector<pair<double, string>> survivors;
+    vector<double> bests; // minimum cost of each epoch
 
-    for (int i = 0; i < EPOCH_AMOUNT; i ++) {
+    AIH::Archive* archive = NULL;
+    if (ARCHIVE_PATH != "") {
+        archive = new AIH::Archive(ARCHIVE_PATH);
+        if (ARCHIVE_SEED > 0) {
+            // the first epoch is bred from the best networks of earlier runs
+            survivors = archive->top(ARCHIVE_SEED);
+            cout << "Seeded " << survivors.size() << " networks from " << archive->index.size() << " in the archive\n";
+        }
+    }
+    if (STEADY_STATE && !SDLH::evolveSteady(b->metrics, archive, survivors, bests)) {
+        return 1;
+    }
+    int epochs = STEADY_STATE ? 0 : EPOCH_AMOUNT; // steady-state evolution has already run its arenas
+    for (int i = 0; i < epochs; i ++) {
         ifstream fin;
-        fin.open("networks/agent.csv");
+        fin.open(NETWORK_PATH);
         string stored; fin >> stored;
-        if (stored == "") {
+        if (stored == "" && NETWORK_PATH != "") {
             cout << "agents.csv file not found, generating randomly\n";
         }
         
         b->quit = false;
-        int tick = 0;
-        for (int i = 0; i < AGENT_AMOUNT; i ++) {
-            SDLH::Agent* a = new SDLH::Agent(dist(mt), dist(mt), dist2(mt), 0, b);
-            if (i < SURVIVOR_REPRODUCTION * survivors.size()) {
-                delete a->nn;
-                a->nn = new AIH::Network(survivors[i % SURVIVOR_REPRODUCTION].second);
+        // networks of this epoch, bred from the survivors of the last one
+        int amount = RACE ? max(RACE_CANDIDATES, AGENT_AMOUNT) : AGENT_AMOUNT;
+        vector<AIH::Network*> nets = SDLH::offspring(survivors, amount, AIH::rng());
+
+        survivors.clear();
+        AIH::Network* best = NULL; // network with the minimum cost, if any are left
+        double least = 0;
+        vector<SDLH::Candidate> ranked;
+        if (RACE) {
+            // successive halving, only promising networks get full episodes
+            vector<SDLH::Candidate> candidates;
+            for (AIH::Network* nn : nets) {
+                candidates.push_back({nn, 0, 0});
             }
-            if (i < (AGENT_AMOUNT * MUTATION_CHANCE)) {
-                // mutate
-                a->nn->mutate(MUTATION_AMOUNT);
+            long long agentTicks = 0;
+            ranked = SDLH::race(b, candidates, mt, agentTicks);
+            if (ranked.empty()) {
+                return 1;
             }
-            b->addAgent(a);
-        }
-        while (!b->quit && tick < EPOCH_LENGTH) {
-            b->loop();
-            tick ++;
-            // novelty bonuses
-            double mxb = 0;
-            for (SDLH::Agent* a : b->getAgents()) {
-                double bonus = 0;
-                for (SDLH::Agent* o : b->getAgents()) {
-                    if (a == o) {
-                        continue;
-                    }
-                    double add = 0;
-                    for (int i = 0; i < a->nn->layers.back()->neurons.size(); i ++) {
-                        add += pow((a->nn->layers.back()->neurons[i]->value - o->nn->layers.back()->neurons[i]->value), 2);
-                    }
-                    bonus += sqrt(add);
-                }
-                a->cost -= bonus * NOVELTY_REWARD;
-                // if (bonus != 0) {
-                //     cout << bonus << "\n";
-                // }
-                mxb = max(mxb, bonus);
+            if (b->quit) { // manually closed
+                break;
+            }
+            for (SDLH::Candidate& c : ranked) {
+                survivors.push_back({c.cost(), c.nn->store()});
+            }
+            best = ranked[0].nn;
+            least = ranked[0].cost();
+            cout << "Agent ticks: " << agentTicks << ", " << (double)agentTicks / ((long long)amount * EPOCH_LENGTH) << " of full episodes\n";
+        } else {
+            for (AIH::Network* nn : nets) SDLH::spawnAgent(b, nn, mt);
+            bool recording = recorder != NULL && i % max(RECORD_EVERY, 1) == 0;
+            if (recording) {
+                recorder->begin(i, b);
+            }
+            if (SDLH::runEpisode(b, EPOCH_LENGTH, recording ? recorder : NULL, false) < 0) {
+                return 1;
+            }
+            if (recording) {
+                recorder->end();
             }
-            cout << mxb << "\n";
-            // proximity rewards
-            for (SDLH::Agent* a : b->getAgents()) {
-                double closest = PROXIMITY_RADIUS;
-                for (SDLH::Agent* o : b->getAgents()) {
-                    if (o == a) {
-                        continue;
-                    }
-                    double dist = sqrt(pow((a->pos.first - o->pos.first), 2) + pow((a->pos.second - o->pos.second), 2));
-                    closest = min(closest, dist);
+            if (b->quit) { // manually closed
+                break;
+            }
+            // extract survivors
+            for (auto agent: b->getAgents()) {
+                survivors.push_back({agent->cost, agent->nn->store()});
+                if (best == NULL || least >= agent->cost) {
+                    best = agent->nn;
+                    least = agent->cost;
                 }
-                a->cost -= ((PROXIMITY_RADIUS - closest) / PROXIMITY_RADIUS) * PROXIMITY_REWARD; 
             }
         }
-        if (b->quit) { // manually closed
-            break;
+        if (b->metrics != NULL) {
+            b->metrics->epoch(i + 1, least);
         }
-
-        // extract survivors
-        survivors.clear();
-        if (b->getAgents().size() == 0) {
+        if (survivors.size() == 0) {
             AIH::Network* nn = new AIH::Network();
             survivors = {{0, nn->store()}};
-        } else {
-            for (auto agent: b->getAgents()) {
-                survivors.push_back({agent->cost, agent->nn->store()});
-            }
         }
         sort(survivors.begin(), survivors.end());
         // get best
-        if (b->getAgents().size() > 0) {
-            SDLH::Agent* min = b->getAgents()[0];
-            for (SDLH::Agent* a : b->getAgents()) {
-                if (min->cost >= a->cost) {
-                    min = a;
-                }
+        if (best != NULL) {
+            cout << "Minimum cost: " << least << "\n";
+            bests.push_back(least);
+            if (archive != NULL) archive->addElites(survivors);
+            if (SENSOR_CACHE) {
+                cout << "Sensor cache hit rate: " << b->sensorHitRate() << "\n";
+                b->sensorHits = 0;
+                b->sensorMisses = 0;
+            }
+            if (NETWORK_PATH != "") {
+                best->store(NETWORK_PATH);
             }
-            cout << "Minimum cost: " << min->cost << "\n";
-            min->nn->store("networks/agent.csv");
+        }
+        for (SDLH::Candidate& c : ranked) {
+            delete c.nn;
         }
         b->clearAgents();
         b->clearObstacles();
         b->loop();
-        SDL_Delay(750);
+        if (!HEADLESS) {
+            SDL_Delay(750);
+        }
     }
 
-    b->destroy();
+    // machine readable summary, read by parameter sweeps
+    if (bests.size() > 0) {
+        double mean = 0;
+        for (double c : bests) mean += c;
+        cout << "RESULT " << bests.back() << " " << mean / bests.size() << "\n";
+    }
+
+    if (recorder != NULL) {
+        cout << "Replay of " << recorder->size() << " bytes recorded to " << RECORD_PATH << "\n";
+        delete recorder;
+    }
+    delete b->metrics;
+    delete archive;
+
+    if (!HEADLESS) {
+        b->destroy();
+    }
 }
\ No newline at end of file
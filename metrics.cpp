@@ -0,0 +1,134 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "arena.h"
+#include "constants.h"
+
+using namespace std;
+
+int64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SDLH::Metrics::Metrics(string name) {
+    /*
+    Constructor for Metrics. The segment is sized to one block and cleared,
+    so a reader that finds it always sees a valid header.
+    */
+    this->name = "/" + name;
+    block = NULL;
+    ok = false;
+    since = nowNs();
+    ticks = 0;
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(MetricsBlock)) != 0) {
+        cout << "Couldn't create the metrics segment " << this->name << "\n";
+        if (fd >= 0) close(fd);
+        return;
+    }
+    void* m = mmap(NULL, sizeof(MetricsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        cout << "Couldn't map the metrics segment " << this->name << "\n";
+        return;
+    }
+    block = (MetricsBlock*)m;
+    // readers check the magic number last, so it is written after everything else
+    block->magic = 0;
+    block->version = METRICS_VERSION;
+    block->seq.store(0);
+    memset(&block->data, 0, sizeof(MetricsData));
+    block->data.pid = getpid();
+    atomic_thread_fence(memory_order_release);
+    block->magic = METRICS_MAGIC;
+    ok = true;
+}
+
+SDLH::Metrics::~Metrics() {
+    if (block != NULL) munmap(block, sizeof(MetricsBlock));
+    if (ok) shm_unlink(name.c_str());
+}
+
+void SDLH::Metrics::begin() {
+    block->seq.store(block->seq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void SDLH::Metrics::end() {
+    block->data.updated = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    block->seq.store(block->seq.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+void SDLH::Metrics::tick(Display* b) {
+    /*
+    Counts the tick and every METRICS_EVERY ticks publishes the display's
+    state. The costs are copied into scratch memory to find the median, so
+    publishing doesn't allocate.
+    */
+    if (!ok) return;
+    ticks ++;
+    if (ticks < max(METRICS_EVERY, 1)) return;
+    int64_t now = nowNs();
+    const vector<Agent*>& agents = b->getAgents();
+    int n = agents.size();
+    double* costs = b->scratch.alloc<double>(max(n, 1));
+    for (int i = 0; i < n; i ++) costs[i] = agents[i]->cost;
+    double best = n > 0 ? *min_element(costs, costs + n) : 0;
+    nth_element(costs, costs + n / 2, costs + n);
+
+    begin();
+    MetricsData& d = block->data;
+    d.ticks = b->ticks;
+    d.ticksPerSecond = ticks * 1e9 / max(now - since, (int64_t)1);
+    d.bestCost = best;
+    d.medianCost = n > 0 ? costs[n / 2] : 0;
+    d.agents = n;
+    d.obstacles = b->getObstacles().size();
+    for (int i = 0; i < TICK_PHASES; i ++) d.phaseMs[i] = b->phaseMs[i];
+    d.allocations = allocations();
+    d.sensorHitRate = b->sensorHitRate();
+    d.tickMs = b->tickMs;
+    d.quality = b->quality;
+    end();
+    since = now;
+    ticks = 0;
+}
+
+void SDLH::Metrics::epoch(long long epoch, double best) {
+    if (!ok) return;
+    begin();
+    block->data.epoch = epoch;
+    block->data.lastBest = best;
+    end();
+}
+
+bool SDLH::readMetrics(const MetricsBlock* block, MetricsData& out) {
+    /*
+    The reading side of the seqlock: an odd seq, or one that changed while
+    copying, means a write got in the way and the copy is tried again, up
+    to METRICS_RETRIES times.
+    */
+    if (block->magic != METRICS_MAGIC || block->version != METRICS_VERSION) return false;
+    for (int tries = 0; tries < METRICS_RETRIES; tries ++) {
+        uint64_t before = block->seq.load(memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(&out, (const void*)&block->data, sizeof(MetricsData));
+        atomic_thread_fence(memory_order_acquire);
+        if (block->seq.load(memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+const char* SDLH::phaseName(int phase) {
+    const char* names[TICK_PHASES] = {"sense", "infer", "integrate", "collide", "score"};
+    return phase >= 0 && phase < TICK_PHASES ? names[phase] : "";
+}
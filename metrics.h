@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+#include "sdl.h"
+
+/*
+Live metrics of a run, published in a POSIX shared memory segment so other
+processes can watch it (see monitor.cpp) without slowing it down.
+
+The segment holds one MetricsBlock. The run writes it under a seqlock:
+seq is made odd before the values change and even again after, and a
+reader copies the values and only keeps the copy if seq was the same even
+number before and after. Writers never wait for readers.
+*/
+
+namespace SDLH {
+    const uint32_t METRICS_MAGIC = 0x4D494141; // "AAIM"
+    const uint32_t METRICS_VERSION = 2;
+    const int METRICS_RETRIES = 100000; // tries readMetrics makes before giving up on a write that doesn't end
+
+    struct MetricsData { // the published values, plain so they can be copied in one go
+        int64_t pid; // process publishing them
+        int64_t updated; // when they were last published, in milliseconds since the unix epoch
+        int64_t epoch; // epochs finished
+        double lastBest; // minimum cost of the last finished epoch
+        int64_t ticks; // ticks the display has run
+        double ticksPerSecond; // over the last METRICS_EVERY ticks
+        double bestCost, medianCost; // of the agents alive now
+        int64_t agents, obstacles;
+        double phaseMs[TICK_PHASES]; // time of each phase of the last tick, 0 unless THREADS is set
+        int64_t allocations; // heap allocations made so far
+        double sensorHitRate;
+        double tickMs; // how long the last tick took
+        int64_t quality; // levels of quality given up to meet TICK_BUDGET
+    };
+
+    struct MetricsBlock { // layout of the segment
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint64_t> seq; // odd while the data is being written
+        MetricsData data;
+    };
+
+    class Metrics { // publishes the state of a running display
+        public:
+            Metrics(std::string name); // creates the segment /name, or reuses it if a previous run left it
+            ~Metrics(); // unmaps and removes the segment
+            void tick(Display* b); // called by Display::loop, publishes every METRICS_EVERY ticks
+            void epoch(long long epoch, double best); // called once an epoch is over
+
+            bool ok; // false if the segment couldn't be made
+        private:
+            void begin(); // start writing, readers retry until end
+            void end();
+
+            std::string name;
+            MetricsBlock* block;
+            int64_t since; // when the ticks per second were last measured, in nanoseconds
+            long long ticks; // ticks since then
+    };
+
+    // Copies the data of a block written by Metrics, retrying while it is
+    // being written. Returns false if it is not a metrics block of this
+    // version, or if a write didn't end within METRICS_RETRIES tries, which
+    // happens when the run died halfway through one.
+    bool readMetrics(const MetricsBlock* block, MetricsData& out);
+    const char* phaseName(int phase); // name of a phase of a phased tick
+};
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+using namespace std;
+
+/*
+Shows the live metrics a run publishes with METRICS_NAME set.
+
+    ./monitor NAME [SECONDS]
+
+Prints them every SECONDS (1 by default) until the run ends. Only reads
+the segment, so any number of monitors can watch a run.
+*/
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: ./monitor NAME [SECONDS]\n";
+        return 1;
+    }
+    string name = "/" + string(argv[1]);
+    double seconds = argc > 2 ? stod(argv[2]) : 1;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        cout << "No run is publishing metrics as " << argv[1] << "\n";
+        return 1;
+    }
+    void* m = mmap(NULL, sizeof(SDLH::MetricsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        cout << "Couldn't map " << name << "\n";
+        return 1;
+    }
+    const SDLH::MetricsBlock* block = (const SDLH::MetricsBlock*)m;
+    SDLH::MetricsData d;
+    cout << fixed << setprecision(3);
+    while (true) {
+        if (!SDLH::readMetrics(block, d)) {
+            if (block->magic != SDLH::METRICS_MAGIC || block->version != SDLH::METRICS_VERSION) {
+                cout << name << " doesn't hold metrics of version " << SDLH::METRICS_VERSION << "\n";
+                return 1;
+            }
+            // a write that never ends, the pid is set once when the segment is made
+            if (kill(block->data.pid, 0) != 0) {
+                cout << "Process " << block->data.pid << " isn't running anymore\n";
+                return 0;
+            }
+            this_thread::sleep_for(chrono::duration<double>(seconds));
+            continue;
+        }
+        // a run that crashed leaves its segment behind
+        if (kill(d.pid, 0) != 0) {
+            cout << "Process " << d.pid << " isn't running anymore\n";
+            return 0;
+        }
+        cout << "epoch " << d.epoch << " (last best " << d.lastBest << ")"
+             << "  tick " << d.ticks << " at " << d.ticksPerSecond << "/s\n"
+             << "  agents " << d.agents << "  obstacles " << d.obstacles
+             << "  best " << d.bestCost << "  median " << d.medianCost << "\n"
+             << "  ms per phase:";
+        for (int i = 0; i < SDLH::TICK_PHASES; i ++) cout << " " << SDLH::phaseName(i) << " " << d.phaseMs[i];
+        cout << "\n  allocations " << d.allocations << "  sensor hit rate " << d.sensorHitRate << "\n"
+             << "  last tick " << d.tickMs << " ms, " << SDLH::qualityName(d.quality) << "\n" << flush;
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+    }
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ai.h"
+#include "config.h"
+#include "codegen.h"
+
+using namespace std;
+
+/*
+Generates straight-line C++ for a stored network, to build a controller
+into another program without the simulator (see codegen.h).
+
+    ./netgen NETWORK NAME [PRUNE] [BITS] [KEY=VALUE ...]
+
+Writes NAME.cpp and NAME.h with a function NAME(in, out). PRUNE drops
+weights smaller than it in magnitude and BITS rounds weights to that many
+bits per layer first, both off when 0. The network is read with the layer
+sizes and activations of the given parameters, so pass the same ones it
+was trained with.
+*/
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: ./netgen NETWORK NAME [PRUNE] [BITS] [KEY=VALUE ...]\n";
+        return 1;
+    }
+    string path = argv[1], name = argv[2];
+    double prune = 0;
+    int bits = 0;
+    vector<char*> rest = {argv[0]};
+    for (int i = 3; i < argc; i ++) {
+        string arg = argv[i];
+        if (arg.find('=') != string::npos) {
+            rest.push_back(argv[i]);
+        } else if (i == 3) {
+            prune = stod(arg);
+        } else {
+            bits = stoi(arg);
+        }
+    }
+    // fewer bits leave no levels and more shift past an int
+    if (bits != 0 && (bits < 2 || bits > 31)) {
+        cout << "BITS has to be between 2 and 31, or 0 to keep the weights as they are\n";
+        cout << "Usage: ./netgen NETWORK NAME [PRUNE] [BITS] [KEY=VALUE ...]\n";
+        return 1;
+    }
+    if (!CFGH::parseArgs(rest.size(), rest.data())) {
+        return 1;
+    }
+    ifstream fin(path);
+    string stored;
+    fin >> stored;
+    if (stored == "") {
+        cout << "Couldn't read a network from " << path << "\n";
+        return 1;
+    }
+    vector<double> vals;
+    bool sparse;
+    if (!AIH::parseNetwork(stored, vals, sparse)) {
+        cout << path << " doesn't hold a network of the given sizes\n";
+        return 1;
+    }
+    AIH::Network nn(stored);
+    int before = nn.connections();
+    if (prune > 0) nn.prune(prune);
+    if (bits > 0) nn.quantize(bits);
+
+    ofstream src(name + ".cpp"), head(name + ".h");
+    src << AIH::generate(&nn, name, path);
+    head << AIH::generateHeader(&nn, name);
+    if (!src || !head) {
+        cout << "Couldn't write " << name << ".cpp and " << name << ".h\n";
+        return 1;
+    }
+    cout << "Wrote " << name << ".cpp and " << name << ".h with " << nn.connections() << " of " << before << " connections\n";
+    return 0;
+}
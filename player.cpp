@@ -0,0 +1,147 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+#include "sdl.h"
+#include "config.h"
+#include "replay.h"
+
+using namespace std;
+
+/*
+Plays back a replay recorded with RECORD_PATH, drawing it the same way a
+live Display does.
+
+    ./player REPLAY [EPOCH] [SPEED] [KEY=VALUE ...]
+
+EPOCH defaults to the last one recorded and SPEED is in ticks per frame.
+While playing, up and down double and halve the speed, left and right go to
+the previous and next recorded epoch and space pauses. The camera moves like
+it does in a live display.
+*/
+
+void place(SDLH::Display* b, SDLH::Replay& r, vector<SDLH::Agent*>& agents) {
+    /*
+    Puts the display's agents where the current frame of the replay has them.
+    */
+    b->clearAgents();
+    while (agents.size() < r.agents.size()) {
+        agents.push_back(new SDLH::Agent(0, 0, 0, 0, b));
+    }
+    for (size_t i = 0; i < r.agents.size(); i ++) {
+        SDLH::ReplayAgent& ra = r.agents[i];
+        if (!ra.alive) continue;
+        SDLH::Agent* a = agents[i];
+        a->pos = {ra.x, ra.y};
+        a->hitbox->x = ra.x;
+        a->hitbox->y = ra.y;
+        a->dir = ra.dir;
+        a->speed = ra.speed;
+        a->health = ra.health;
+        a->cost = ra.cost;
+        b->addAgent(a);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: ./player REPLAY [EPOCH] [SPEED] [KEY=VALUE ...]\n";
+        return 1;
+    }
+    SDLH::Replay r(argv[1]);
+    if (!r.ok) {
+        return 1;
+    }
+    if (r.index.empty()) {
+        cout << "No epochs were recorded\n";
+        return 1;
+    }
+    size_t e = r.index.size() - 1;
+    double speed = 1;
+    // anything after the replay, epoch and speed is a parameter like SHOW_COSTS=false
+    vector<char*> rest = {argv[0]};
+    for (int i = 2; i < argc; i ++) {
+        string arg = argv[i];
+        if (arg.find('=') != string::npos) {
+            rest.push_back(argv[i]);
+        } else if (i == 2) {
+            long long epoch = stoll(arg);
+            while (e > 0 && r.index[e].epoch != epoch) e --;
+            if (r.index[e].epoch != epoch) {
+                cout << "Epoch " << epoch << " wasn't recorded, recorded epochs are";
+                for (SDLH::ReplayEpoch& re : r.index) cout << " " << re.epoch;
+                cout << "\n";
+                return 1;
+            }
+        } else {
+            speed = stod(arg);
+        }
+    }
+    if (!CFGH::parseArgs(rest.size(), rest.data())) {
+        return 1;
+    }
+    // draw at the sizes the replay was recorded with
+    WINDOW_SIZE = r.windowSize;
+    AGENT_SIZE = r.agentSize;
+    OBSTACLE_SIZE = r.obstacleSize;
+    HEADLESS = false;
+    DEBUG_WIND = false;
+    SHOW_RAYS = false;
+
+    SDLH::Display* b = new SDLH::Display(WINDOW_SIZE, WINDOW_SIZE);
+    b->setWorld(r.worldWidth, r.worldHeight);
+    b->initBasics();
+    vector<SDLH::Agent*> agents;
+    vector<SDLH::Obstacle*> obstacles;
+
+    r.seek(r.index[e].epoch);
+    r.next();
+    cout << "Epoch " << r.index[e].epoch << ", " << r.index[e].frames << " ticks\n";
+    bool paused = false;
+    double ahead = 0; // ticks owed to the speed so far
+    while (!b->quit) {
+        while (SDL_PollEvent(&b->e)) {
+            if (b->e.type == SDL_QUIT) b->quit = true;
+            if (b->e.window.event == SDL_WINDOWEVENT_CLOSE) b->quit = true;
+            b->handle(b->e);
+            if (b->e.type != SDL_KEYDOWN) continue;
+            int key = b->e.key.keysym.sym;
+            if (key == SDLK_UP) speed *= 2;
+            if (key == SDLK_DOWN) speed /= 2;
+            if (key == SDLK_SPACE) paused = !paused;
+            if ((key == SDLK_LEFT && e > 0) || (key == SDLK_RIGHT && e + 1 < r.index.size())) {
+                if (key == SDLK_LEFT) e --;
+                else e ++;
+                r.seek(r.index[e].epoch);
+                r.next();
+                cout << "Epoch " << r.index[e].epoch << ", " << r.index[e].frames << " ticks\n";
+            }
+        }
+        if (!paused) {
+            ahead += speed;
+            // stays on the last frame once the epoch is over
+            for (; ahead >= 1; ahead --) r.next();
+        }
+
+        place(b, r, agents);
+        SDL_SetRenderDrawColor(b->renderer, 0x11, 0x11, 0x11, 0xFF);
+        SDL_RenderClear(b->renderer);
+        b->measureCosts();
+        for (SDLH::Agent* a : b->getAgents()) {
+            if (b->visible(a->pos.first, a->pos.second, a->hitbox->w, a->hitbox->h)) a->draw(b);
+        }
+        while (obstacles.size() < r.obstacles.size()) {
+            obstacles.push_back(new SDLH::Obstacle(0, 0, 0, 0, b, NULL));
+        }
+        for (size_t i = 0; i < r.obstacles.size(); i ++) {
+            obstacles[i]->hitbox->x = r.obstacles[i].first;
+            obstacles[i]->hitbox->y = r.obstacles[i].second;
+            if (b->visible(r.obstacles[i].first, r.obstacles[i].second, OBSTACLE_SIZE, OBSTACLE_SIZE)) obstacles[i]->draw(b);
+        }
+        b->render();
+        SDL_RenderPresent(b->renderer);
+        SDL_Delay(16);
+    }
+    b->destroy();
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+
+#include "ai.h"
+#include "config.h"
+#include "checkpolicy.h"
+
+using namespace std;
+
+/*
+Checks that code generated by netgen computes exactly what Network::run
+does, by running both on the same random inputs.
+
+    ./policycheck NETWORK RUNS [PRUNE] [BITS] [KEY=VALUE ...]
+
+checkpolicy.cpp has to be generated from NETWORK by netgen with the same
+PRUNE, BITS and parameters, which the Makefile does for make check. The
+network is pruned and quantized the way netgen does it, then both run on
+RUNS inputs in [0, 1) and every output has to be bit for bit the same.
+Exits with 1 if any differs.
+*/
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: ./policycheck NETWORK RUNS [PRUNE] [BITS] [KEY=VALUE ...]\n";
+        return 1;
+    }
+    string path = argv[1];
+    int runs = stoi(argv[2]);
+    double prune = 0;
+    int bits = 0;
+    vector<char*> rest = {argv[0]};
+    for (int i = 3; i < argc; i ++) {
+        string arg = argv[i];
+        if (arg.find('=') != string::npos) {
+            rest.push_back(argv[i]);
+        } else if (i == 3) {
+            prune = stod(arg);
+        } else {
+            bits = stoi(arg);
+        }
+    }
+    if (!CFGH::parseArgs(rest.size(), rest.data())) {
+        return 1;
+    }
+    ifstream fin(path);
+    string stored;
+    fin >> stored;
+    vector<double> vals;
+    bool sparse;
+    if (!AIH::parseNetwork(stored, vals, sparse)) {
+        cout << path << " doesn't hold a network of the given sizes\n";
+        return 1;
+    }
+    AIH::Network nn(stored);
+    if (prune > 0) nn.prune(prune);
+    if (bits > 0) nn.quantize(bits);
+    if ((int)nn.layers[0]->neurons.size() != checkpolicy_inputs || (int)nn.layers.back()->neurons.size() != checkpolicy_outputs) {
+        cout << "checkpolicy wasn't generated with the sizes of " << path << "\n";
+        return 1;
+    }
+
+    mt19937 mt(1);
+    uniform_real_distribution<double> dist(0, 1);
+    AIH::real in[checkpolicy_inputs], out[checkpolicy_outputs];
+    int differ = 0;
+    for (int r = 0; r < runs; r ++) {
+        for (int i = 0; i < checkpolicy_inputs; i ++) {
+            in[i] = dist(mt);
+            nn.layers[0]->neurons[i]->value = in[i];
+        }
+        const vector<AIH::real>& res = nn.run();
+        checkpolicy(in, out);
+        if (memcmp(res.data(), out, sizeof(out)) != 0) differ ++;
+    }
+    cout << runs << " runs of " << path << ", outputs differing from Network::run: " << differ << "\n";
+    return differ == 0 ? 0 : 1;
+}
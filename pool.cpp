@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "pool.h"
+
+using namespace std;
+
+SDLH::ThreadPool::ThreadPool(int size) : size(max(size, 1)), ranges(max(size, 1)) {
+    /*
+    Constructor for ThreadPool. The threads sleep until a loop is started.
+    */
+    generation = 0;
+    stop = false;
+    active = 0;
+    call = NULL;
+    ctx = NULL;
+    for (int w = 1; w < this->size; w ++) {
+        threads.push_back(thread(&ThreadPool::serve, this, w));
+    }
+}
+
+SDLH::ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> g(lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for (thread& t : threads) t.join();
+}
+
+void SDLH::ThreadPool::start(int n, void (*call)(void*, int, int, int), void* ctx) {
+    /*
+    Every worker starts with an even share of the items. The calling thread
+    works too, then waits for every thread to have left the loop, so the
+    next loop can't be mixed up with this one.
+    */
+    this->call = call;
+    this->ctx = ctx;
+    for (int w = 0; w < size; w ++) {
+        lock_guard<mutex> g(ranges[w].lock);
+        ranges[w].next = (long long)n * w / size;
+        ranges[w].end = (long long)n * (w + 1) / size;
+    }
+    active = size - 1;
+    {
+        lock_guard<mutex> g(lock);
+        generation ++;
+    }
+    wake.notify_all();
+    work(0);
+    unique_lock<mutex> l(lock);
+    idle.wait(l, [this] () { return active == 0; });
+}
+
+void SDLH::ThreadPool::work(int worker) {
+    int begin, end;
+    while (take(worker, begin, end)) call(ctx, begin, end, worker);
+}
+
+bool SDLH::ThreadPool::take(int worker, int& begin, int& end) {
+    /*
+    Takes the next POOL_GRAIN items of the worker's own range. Once that is
+    empty, it steals the back half of the first other range that has items
+    left, keeps one chunk of it and makes the rest its own range, so a worker
+    that got the expensive items gets helped without any central queue.
+    */
+    Range& own = ranges[worker];
+    {
+        lock_guard<mutex> g(own.lock);
+        if (own.next < own.end) {
+            begin = own.next;
+            end = min(own.next + POOL_GRAIN, own.end);
+            own.next = end;
+            return true;
+        }
+    }
+    for (int k = 1; k < size; k ++) {
+        Range& victim = ranges[(worker + k) % size];
+        int from, to;
+        {
+            lock_guard<mutex> g(victim.lock);
+            int left = victim.end - victim.next;
+            if (left <= 0) continue;
+            from = victim.next + left / 2;
+            to = victim.end;
+            victim.end = from;
+        }
+        begin = from;
+        end = min(from + POOL_GRAIN, to);
+        lock_guard<mutex> g(own.lock);
+        own.next = end;
+        own.end = to;
+        return true;
+    }
+    return false;
+}
+
+void SDLH::ThreadPool::serve(int worker) {
+    long long seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> l(lock);
+            wake.wait(l, [this, &seen] () { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+        work(worker);
+        if (-- active == 0) {
+            lock_guard<mutex> g(lock);
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace SDLH {
+    const int POOL_GRAIN = 16; // items a worker takes from its range at a time
+
+    class ThreadPool { // persistent threads that split loops over items, stealing work from each other when they run out
+        public:
+            ThreadPool(int size); // starts size - 1 threads, the calling thread is the last worker
+            ~ThreadPool(); // stops and joins the threads
+            // calls f(i, worker) for every i in [0, n) and returns once all are done. worker
+            // is in [0, size) and no two calls with the same worker run at the same time
+            template <typename F> void run(int n, F& f);
+
+            int size; // workers, including the calling thread
+        private:
+            struct Range { // items a worker still has to do, padded so workers don't share cache lines
+                std::mutex lock;
+                int next, end;
+                char pad[64];
+            };
+            void start(int n, void (*call)(void*, int, int, int), void* ctx); // hands out a loop and works on it until it is done
+            void work(int worker); // runs chunks of the current loop until no range has any left
+            bool take(int worker, int& begin, int& end); // next chunk of the worker's own range, or half of another's
+            void serve(int worker); // what the started threads do until the pool is destroyed
+
+            std::vector<std::thread> threads;
+            std::vector<Range> ranges;
+            std::mutex lock; // guards generation and stop for the condition variables
+            std::condition_variable wake, idle;
+            long long generation; // how many loops have been started
+            bool stop;
+            std::atomic<int> active; // started threads still working on the current loop
+            void (*call)(void*, int, int, int); // runs items [begin, end) of the current loop as a worker
+            void* ctx;
+    };
+};
+
+template <typename F> void SDLH::ThreadPool::run(int n, F& f) {
+    /*
+    Loops too small to be worth waking the threads for are run right here.
+    The loop body is passed on as a plain function pointer and a pointer to
+    f, so nothing is allocated.
+    */
+    if (n <= 0) return;
+    if (size <= 1 || n <= POOL_GRAIN) {
+        for (int i = 0; i < n; i ++) f(i, 0);
+        return;
+    }
+    start(n, [] (void* c, int begin, int end, int worker) {
+        F& g = *(F*)c;
+        for (int i = begin; i < end; i ++) g(i, worker);
+    }, &f);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/*
+The scalar type of everything that runs every tick: the values, weights and
+biases of networks, ray directions and readings, and the positions and
+velocities of agents and obstacles. It is double unless built with
+-DSINGLE_PRECISION (make PRECISION=float), which halves the memory those
+loops go through and doubles how many values fit in a SIMD register.
+
+Costs, genomes (see Network::gather), stored networks, archives and the
+buffers of env.h stay double in both builds, so files made by one build can
+be read by the other and their fitness outcomes compared.
+*/
+
+namespace AIH {
+#ifdef SINGLE_PRECISION
+    typedef float real;
+#else
+    typedef double real;
+#endif
+}
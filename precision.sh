@@ -0,0 +1,44 @@
+#!/bin/sh
+# Compares how networks do in a double and a float build (see precision.h).
+#
+#     ./precision.sh MODE EPISODES NETWORK [NETWORK ...] [KEY=VALUE ...]
+#
+# Builds eval with PRECISION=double and PRECISION=float in temporary copies of
+# the tree, plays the same seeded episodes in both (see eval.cpp) and fails
+# unless the mean cost of every network differs by at most TOLERANCE (3 by
+# default) standard errors of the two means combined. Runs drift apart as
+# rounding differs, so their costs are compared as samples, not episode by
+# episode.
+
+TOLERANCE=${TOLERANCE:-3}
+if [ $# -lt 3 ]; then
+    echo "Usage: ./precision.sh MODE EPISODES NETWORK [NETWORK ...] [KEY=VALUE ...]"
+    exit 1
+fi
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+for p in double float; do
+    mkdir "$dir/$p"
+    cp *.cpp *.h Makefile "$dir/$p"
+    make -s -C "$dir/$p" PRECISION=$p eval > /dev/null || exit 1
+    "$dir/$p/eval" "$@" > "$dir/$p.txt" || exit 1
+done
+
+# the path, mean cost and standard error of every network, in the order eval prints them
+costs() {
+    awk '$NF == "agents" { path = substr($1, 1, length($1) - 1) } $1 == "cost" { gsub(/[(),]/, ""); print path, $2, $7 }' "$1"
+}
+costs "$dir/double.txt" > "$dir/double.costs"
+costs "$dir/float.txt" > "$dir/float.costs"
+paste "$dir/double.costs" "$dir/float.costs" | awk -v tol="$TOLERANCE" '
+    {
+        se = sqrt($3 * $3 + $6 * $6)
+        diff = $2 - $5
+        if (diff < 0) diff = -diff
+        ok = diff <= tol * se
+        printf "%s: double %.3f, float %.3f, %.2f standard errors apart%s\n", $1, $2, $5, (se > 0 ? diff / se : 0), (ok ? "" : " (too far)")
+        if (!ok) bad = 1
+    }
+    END { exit bad }
+'
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include "race.h"
+#include "constants.h"
+
+using namespace std;
+
+double SDLH::Candidate::cost() const {
+    return episodes > 0 ? score / episodes * EPOCH_LENGTH : 0;
+}
+
+SDLH::Display* SDLH::makeArena() {
+    Display* b = new Display(WINDOW_SIZE, WINDOW_SIZE);
+    b->headless = true;
+    b->reserve();
+    return b;
+}
+
+SDLH::Agent* SDLH::spawnAgent(Display* b, AIH::Network* nn, mt19937& mt) {
+    uniform_real_distribution<double> dist2(0.0, 359.0);
+    uniform_int_distribution<int> distx(0, b->worldWidth);
+    uniform_int_distribution<int> disty(0, b->worldHeight);
+    int x = distx(mt), y = disty(mt);
+    Agent* a = new Agent(x, y, dist2(mt), 0, b);
+    delete a->nn;
+    a->nn = nn;
+    b->addAgent(a);
+    return a;
+}
+
+int SDLH::runEpisode(Display* b, int length, Recorder* recorder, bool settle) {
+    /*
+    Runs one episode with the agents already in the display. The rankings
+    are kept between calls so that checking them doesn't allocate, one set
+    per thread since steady-state evolution runs episodes side by side.
+    */
+    static thread_local vector<int> order, last;
+    int tick = 0, still = 0;
+    last.clear();
+    while (!b->quit && tick < length && b->getAgents().size() > 0) {
+        long long allocs = SDLH::allocations();
+        b->loop();
+        tick ++;
+        // novelty and proximity rewards
+        double mxb = b->reward();
+        if (!HEADLESS) cout << mxb << "\n";
+        if (recorder != NULL) {
+            recorder->frame(b);
+        }
+        if (settle && RACE_PATIENCE > 0) {
+            // the episode has settled once the order of the agents stops changing
+            const vector<Agent*>& v = b->getAgents();
+            order.clear();
+            for (int i = 0; i < (int)v.size(); i ++) order.push_back(i);
+            sort(order.begin(), order.end(), [&v] (int x, int y) { return v[x]->cost < v[y]->cost; });
+            for (int& i : order) i = v[i]->id;
+            still = order == last ? still + 1 : 0;
+            swap(order, last);
+            if (still >= RACE_PATIENCE) break;
+        }
+        // once warmed up, a tick should run entirely out of preallocated memory
+        if (CHECK_ALLOCATIONS && tick > ALLOCATION_WARMUP && SDLH::allocations() != allocs) {
+            cout << "Tick " << tick << " made " << SDLH::allocations() - allocs << " heap allocations\n";
+            return -1;
+        }
+    }
+    return tick;
+}
+
+vector<SDLH::Candidate> SDLH::race(Display* b, vector<Candidate> candidates, mt19937& mt, long long& agentTicks) {
+    /*
+    Each round shuffles the candidates into arenas of AGENT_AMOUNT agents. If
+    the last arena isn't full it is topped up with candidates that already
+    played, whose results there aren't counted. Scores are costs per tick so
+    that episodes that stopped early compare fairly.
+    */
+    int length = min(RACE_LENGTH, EPOCH_LENGTH);
+    while (true) {
+        bool last = (int)candidates.size() <= AGENT_AMOUNT || length >= EPOCH_LENGTH;
+        if (last) length = EPOCH_LENGTH;
+        for (Candidate& c : candidates) {
+            c.score = 0;
+            c.episodes = 0;
+        }
+        for (int r = 0; r < (last ? max(RACE_REPEATS, 1) : 1); r ++) {
+            shuffle(candidates.begin(), candidates.end(), mt);
+            int n = candidates.size();
+            for (int start = 0; start < n; start += AGENT_AMOUNT) {
+                int scored = min(AGENT_AMOUNT, n - start);
+                int size = min(AGENT_AMOUNT, n);
+                for (int k = 0; k < size; k ++) spawnAgent(b, candidates[(start + k) % n].nn, mt);
+                vector<Agent*> agents = b->getAgents();
+                int ticks = runEpisode(b, length, NULL, true);
+                if (ticks < 0) return {};
+                agentTicks += (long long)ticks * size;
+                for (int k = 0; k < scored; k ++) {
+                    candidates[start + k].score += agents[k]->cost / max(ticks, 1);
+                    candidates[start + k].episodes ++;
+                }
+                for (Agent* a : agents) {
+                    a->nn = NULL;
+                    delete a;
+                }
+                b->clearAgents();
+                b->clearObstacles();
+                if (b->quit) return candidates;
+            }
+        }
+        sort(candidates.begin(), candidates.end(), [] (const Candidate& x, const Candidate& y) { return x.cost() < y.cost(); });
+        if (last) break;
+        int keep = max(AGENT_AMOUNT, (int)ceil(candidates.size() * RACE_KEEP));
+        for (int k = keep; k < (int)candidates.size(); k ++) delete candidates[k].nn;
+        candidates.resize(min(keep, (int)candidates.size()));
+        length *= 2;
+    }
+    return candidates;
+}
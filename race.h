@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "sdl.h"
+#include "ai.h"
+#include "replay.h"
+
+namespace SDLH {
+    struct Candidate { // a network competing for survival in a race
+        AIH::Network* nn;
+        double score; // summed cost per tick of its episodes
+        int episodes; // episodes it was scored in
+        double cost() const; // mean cost scaled to a full EPOCH_LENGTH episode
+    };
+
+    // Runs the agents in b for up to length ticks and returns how many ran, or
+    // -1 if CHECK_ALLOCATIONS caught a tick allocating. Stops early once every
+    // agent is dead or, if settle is set, once the ranking by cost has stayed
+    // the same for RACE_PATIENCE ticks.
+    int runEpisode(Display* b, int length, Recorder* recorder, bool settle);
+    Display* makeArena(); // a headless display with room reserved, to run episodes in
+    // Adds an agent running nn to b at a place and direction drawn from mt, in
+    // that order. The agent owns nn and the caller owns the agent.
+    Agent* spawnAgent(Display* b, AIH::Network* nn, std::mt19937& mt);
+
+    // Successive halving: every candidate plays short episodes and only the
+    // best RACE_KEEP of them go on to episodes twice as long, until AGENT_AMOUNT
+    // are left to play RACE_REPEATS full episodes. Returns the candidates that
+    // made it to the last round, best first. Stops early if b is closed and
+    // returns nothing if an episode failed.
+    std::vector<Candidate> race(Display* b, std::vector<Candidate> candidates, std::mt19937& mt, long long& agentTicks);
+};
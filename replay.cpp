@@ -0,0 +1,381 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "replay.h"
+#include "constants.h"
+
+using namespace std;
+
+// how finely values are quantized, see replay.h
+const double POS_SCALE = 16;
+const double DIR_SCALE = 100;
+const double SPEED_SCALE = 1000;
+const double COST_SCALE = 100;
+
+unsigned long long zigzag(long long v) {
+    return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63);
+}
+
+long long unzigzag(unsigned long long v) {
+    return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+/*
+Recorder
+*/
+
+SDLH::Recorder::Recorder(string path, Display* b) {
+    /*
+    Constructor for Recorder. Frames are collected in a buffer that is written
+    out once it is half full, so recording a tick is just appending bytes.
+    */
+    file = fopen(path.c_str(), "wb");
+    ok = file != NULL;
+    if (!ok) cout << "Couldn't open " << path << " to record a replay\n";
+    written = 0;
+    recording = false;
+    buffer.reserve(1 << 20);
+    buffer.insert(buffer.end(), {'A', 'I', 'R', 'P'});
+    put(REPLAY_VERSION);
+    put(WINDOW_SIZE);
+    put(b->worldWidth);
+    put(b->worldHeight);
+    put(AGENT_SIZE);
+    put(OBSTACLE_SIZE);
+}
+
+SDLH::Recorder::~Recorder() {
+    /*
+    Destructor for Recorder. Writes the index of the recorded epochs and the
+    footer that points to it.
+    */
+    if (recording) end();
+    long long at = size();
+    put(index.size());
+    for (ReplayEpoch& e : index) {
+        put(e.epoch);
+        put(e.offset);
+        put(e.agents);
+        put(e.frames);
+    }
+    for (int i = 0; i < 8; i ++) buffer.push_back((at >> (8 * i)) & 0xFF);
+    flush();
+    if (ok) fclose(file);
+}
+
+long long SDLH::Recorder::size() {
+    return written + buffer.size();
+}
+
+void SDLH::Recorder::flush() {
+    if (ok && buffer.size() > 0) fwrite(buffer.data(), 1, buffer.size(), file);
+    written += buffer.size();
+    buffer.clear();
+}
+
+void SDLH::Recorder::put(unsigned long long v) {
+    /*
+    Appends v as a varint: 7 bits per byte, lowest first, with the top bit
+    set on every byte but the last.
+    */
+    while (v >= 0x80) {
+        buffer.push_back((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    buffer.push_back(v);
+}
+
+void SDLH::Recorder::putDelta(ReplayTrack& t, int k, long long v) {
+    /*
+    Predicts the value from its last change and stores only the error.
+    */
+    put(zigzag(v - (t.last[k] + t.delta[k])));
+    t.delta[k] = v - t.last[k];
+    t.last[k] = v;
+}
+
+void SDLH::Recorder::begin(int epoch, Display* b) {
+    /*
+    Starts a new epoch with the agents that are in the display now. Everything
+    is sized here so that recording its frames doesn't allocate.
+    */
+    if (recording) end();
+    recording = true;
+    index.push_back({epoch, size(), b->agentIds, 0});
+    int n = b->agentIds;
+    agentTracks.assign(n, ReplayTrack());
+    alive.assign(n, 0);
+    byId.assign(n, NULL);
+    put(b->getAgents().size());
+    for (Agent* a : b->getAgents()) {
+        alive[a->id] = 1;
+        put(a->id);
+    }
+    size_t most = max(b->getObstacles().capacity(), (size_t)64);
+    seen.clear();
+    seenTracks.clear();
+    for (vector<Obstacle*>* v : {&seen, &current}) v->reserve(most);
+    for (vector<ReplayTrack>* v : {&seenTracks, &currentTracks}) v->reserve(most);
+    gone.reserve(most);
+}
+
+void SDLH::Recorder::frame(Display* b) {
+    /*
+    Appends the state of the display after a tick.
+    */
+    if (!recording) return;
+    if (buffer.size() > buffer.capacity() / 2) flush();
+    index.back().frames ++;
+
+    // agents that died since the last frame
+    fill(byId.begin(), byId.end(), (Agent*)NULL);
+    for (Agent* a : b->getAgents()) {
+        if (a->id < (int)byId.size()) byId[a->id] = a;
+    }
+    int died = 0;
+    for (size_t i = 0; i < byId.size(); i ++) {
+        if (alive[i] && byId[i] == NULL) died ++;
+    }
+    put(died);
+    for (size_t i = 0; i < byId.size(); i ++) {
+        if (alive[i] && byId[i] == NULL) {
+            put(i);
+            alive[i] = 0;
+        }
+    }
+    for (size_t i = 0; i < byId.size(); i ++) {
+        Agent* a = byId[i];
+        if (!alive[i] || a == NULL) continue;
+        ReplayTrack& t = agentTracks[i];
+        putDelta(t, 0, llround(a->pos.first * POS_SCALE));
+        putDelta(t, 1, llround(a->pos.second * POS_SCALE));
+        putDelta(t, 2, llround(a->dir * DIR_SCALE));
+        putDelta(t, 3, llround(a->speed * SPEED_SCALE));
+        putDelta(t, 4, a->health);
+        putDelta(t, 5, llround(a->cost * COST_SCALE));
+    }
+
+    // obstacles only ever get removed or added to the end, so one pass over
+    // both lists finds the ones that disappeared
+    const vector<Obstacle*>& now = b->getObstacles();
+    gone.clear();
+    current.clear();
+    currentTracks.clear();
+    size_t j = 0;
+    for (size_t i = 0; i < seen.size(); i ++) {
+        if (j < now.size() && now[j] == seen[i]) {
+            current.push_back(seen[i]);
+            currentTracks.push_back(seenTracks[i]);
+            j ++;
+        } else {
+            gone.push_back(i);
+        }
+    }
+    size_t kept = current.size();
+    put(gone.size());
+    for (int i : gone) put(i);
+    put(now.size() - j);
+    for (; j < now.size(); j ++) {
+        ReplayTrack t = ReplayTrack();
+        t.last[0] = llround(now[j]->pos.first * POS_SCALE);
+        t.last[1] = llround(now[j]->pos.second * POS_SCALE);
+        put(zigzag(t.last[0]));
+        put(zigzag(t.last[1]));
+        current.push_back(now[j]);
+        currentTracks.push_back(t);
+    }
+    for (size_t i = 0; i < kept; i ++) {
+        putDelta(currentTracks[i], 0, llround(current[i]->pos.first * POS_SCALE));
+        putDelta(currentTracks[i], 1, llround(current[i]->pos.second * POS_SCALE));
+    }
+    swap(seen, current);
+    swap(seenTracks, currentTracks);
+}
+
+void SDLH::Recorder::end() {
+    /*
+    Finishes the current epoch and writes it out.
+    */
+    recording = false;
+    flush();
+    if (ok) fflush(file);
+}
+
+/*
+Replay
+*/
+
+SDLH::Replay::Replay(string path) {
+    /*
+    Constructor for Replay. The file is mapped instead of read, so opening a
+    long replay is instant and only the frames that are played get loaded.
+    */
+    ok = false;
+    data = NULL;
+    size = 0;
+    current = NULL;
+    frame = 0;
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < 12) {
+        cout << "Couldn't read replay " << path << "\n";
+        if (fd >= 0) close(fd);
+        return;
+    }
+    size = st.st_size;
+    void* m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        cout << "Couldn't map replay " << path << "\n";
+        size = 0;
+        return;
+    }
+    data = (const unsigned char*)m;
+    if (memcmp(data, "AIRP", 4) != 0) {
+        cout << path << " is not a replay\n";
+        return;
+    }
+    at = data + 4;
+    if ((int)get() != REPLAY_VERSION) {
+        cout << path << " has an unknown replay version\n";
+        return;
+    }
+    windowSize = get();
+    worldWidth = get();
+    worldHeight = get();
+    agentSize = get();
+    obstacleSize = get();
+    // the footer points to the index
+    unsigned long long offset = 0;
+    for (int i = 0; i < 8; i ++) offset |= (unsigned long long)data[size - 8 + i] << (8 * i);
+    if (offset >= size - 8) {
+        cout << path << " has no index, the run probably didn't finish\n";
+        return;
+    }
+    at = data + offset;
+    long long n = get();
+    for (long long i = 0; i < n; i ++) {
+        ReplayEpoch e;
+        e.epoch = get();
+        e.offset = get();
+        e.agents = get();
+        e.frames = get();
+        index.push_back(e);
+    }
+    ok = true;
+}
+
+SDLH::Replay::~Replay() {
+    if (data != NULL) munmap((void*)data, size);
+}
+
+unsigned long long SDLH::Replay::get() {
+    /*
+    Reads one varint, stopping at the end of the file.
+    */
+    unsigned long long v = 0;
+    int shift = 0;
+    while (at < data + size) {
+        unsigned char c = *at ++;
+        v |= (unsigned long long)(c & 0x7F) << shift;
+        if (!(c & 0x80)) break;
+        shift += 7;
+    }
+    return v;
+}
+
+long long SDLH::Replay::getDelta(ReplayTrack& t, int k) {
+    /*
+    Inverse of Recorder::putDelta.
+    */
+    long long v = t.last[k] + t.delta[k] + unzigzag(get());
+    t.delta[k] = v - t.last[k];
+    t.last[k] = v;
+    return v;
+}
+
+bool SDLH::Replay::seek(long long epoch) {
+    /*
+    Moves to the start of a recorded epoch.
+    */
+    current = NULL;
+    for (ReplayEpoch& e : index) {
+        if (e.epoch == epoch) current = &e;
+    }
+    if (current == NULL) return false;
+    at = data + current->offset;
+    frame = 0;
+    agents.assign(current->agents, ReplayAgent());
+    agentTracks.assign(current->agents, ReplayTrack());
+    obstacles.clear();
+    obstacleTracks.clear();
+    long long n = get();
+    for (long long i = 0; i < n; i ++) {
+        long long id = get();
+        if (id < current->agents) agents[id].alive = true;
+    }
+    return true;
+}
+
+bool SDLH::Replay::next() {
+    /*
+    Decodes one frame into agents and obstacles, mirroring Recorder::frame.
+    */
+    if (current == NULL || frame >= current->frames) return false;
+    frame ++;
+
+    long long died = get();
+    for (long long i = 0; i < died; i ++) {
+        long long id = get();
+        if (id < current->agents) agents[id].alive = false;
+    }
+    for (size_t i = 0; i < agents.size(); i ++) {
+        ReplayAgent& a = agents[i];
+        if (!a.alive) continue;
+        ReplayTrack& t = agentTracks[i];
+        a.x = getDelta(t, 0) / POS_SCALE;
+        a.y = getDelta(t, 1) / POS_SCALE;
+        a.dir = getDelta(t, 2) / DIR_SCALE;
+        a.speed = getDelta(t, 3) / SPEED_SCALE;
+        a.health = getDelta(t, 4);
+        a.cost = getDelta(t, 5) / COST_SCALE;
+    }
+
+    long long gone = get();
+    nextTracks.clear();
+    size_t g = gone > 0 ? get() : obstacleTracks.size();
+    for (size_t i = 0; i < obstacleTracks.size(); i ++) {
+        if (i == g) {
+            g = -- gone > 0 ? get() : obstacleTracks.size();
+            continue;
+        }
+        nextTracks.push_back(obstacleTracks[i]);
+    }
+    size_t kept = nextTracks.size();
+    long long added = get();
+    for (long long i = 0; i < added; i ++) {
+        ReplayTrack t = ReplayTrack();
+        t.last[0] = unzigzag(get());
+        t.last[1] = unzigzag(get());
+        nextTracks.push_back(t);
+    }
+    for (size_t i = 0; i < kept; i ++) {
+        getDelta(nextTracks[i], 0);
+        getDelta(nextTracks[i], 1);
+    }
+    swap(obstacleTracks, nextTracks);
+    obstacles.resize(obstacleTracks.size());
+    for (size_t i = 0; i < obstacles.size(); i ++) {
+        obstacles[i] = {obstacleTracks[i].last[0] / POS_SCALE, obstacleTracks[i].last[1] / POS_SCALE};
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "sdl.h"
+
+/*
+Replay files hold the world state of every recorded tick so a run can be
+watched afterwards without rendering it live.
+
+Everything is written as LEB128 varints. Values are quantized to integers
+(positions in 1/16 pixel, angles in 1/100 degree, speeds in 1/1000 and costs
+in 1/100) and each one is stored as the zigzag encoded difference from a
+linear prediction of its last two values, so things moving at a steady pace
+take a single byte per value.
+
+    header: "AIRP", version, WINDOW_SIZE, world width and height, AGENT_SIZE, OBSTACLE_SIZE
+    epochs: one after another, each the agents alive at its start (count, ids)
+            followed by its frames back to back
+    frame:  agents that died (count, ids)
+            agent values (x, y, dir, speed, health, cost) of each living agent in id order
+            obstacles that disappeared (count, indices into the last frame's obstacles)
+            obstacles that appeared (count, x, y each, absolute)
+            obstacle values (x, y) of every obstacle from before this frame
+    index:  count, then epoch, offset, agents, frames of each epoch
+    footer: offset of the index as 8 little endian bytes
+
+The index at the end lets a player map the file and jump to any epoch.
+*/
+
+namespace SDLH {
+    const int REPLAY_VERSION = 2;
+    const int REPLAY_AGENT_VALUES = 6; // x, y, dir, speed, health, cost
+
+    struct ReplayTrack { // quantized values of one thing and how they changed last frame
+        long long last[REPLAY_AGENT_VALUES];
+        long long delta[REPLAY_AGENT_VALUES];
+    };
+
+    struct ReplayEpoch { // where one recorded epoch is in a replay file
+        long long epoch;
+        long long offset; // byte offset of its first frame
+        long long agents; // ids handed out to its agents
+        long long frames;
+    };
+
+    class Recorder { // writes the ticks of a Display to a replay file
+        public:
+            Recorder(std::string path, Display* b); // opens the file and writes the header for recording b
+            ~Recorder(); // writes the index and closes the file
+            void begin(int epoch, Display* b); // start recording a new epoch
+            void frame(Display* b); // record the state after a tick, doesn't allocate once warmed up
+            void end(); // finish the current epoch
+
+            long long size(); // bytes recorded so far
+
+            bool ok; // whether the file could be opened
+        private:
+            void flush(); // write the buffer out to the file
+            void put(unsigned long long v); // append one varint
+            void putDelta(ReplayTrack& t, int k, long long v); // append the prediction error of a value and update the track
+
+            FILE* file;
+            long long written; // bytes already in the file
+            std::vector<unsigned char> buffer; // encoded frames not written yet
+            std::vector<ReplayEpoch> index;
+            bool recording;
+            std::vector<ReplayTrack> agentTracks; // indexed by agent id
+            std::vector<Agent*> byId; // agents of the current frame by id, NULL if dead
+            std::vector<char> alive; // indexed by agent id
+            std::vector<Obstacle*> seen, current; // obstacles of the last frame and the one being recorded
+            std::vector<ReplayTrack> seenTracks, currentTracks;
+            std::vector<int> gone; // indices of obstacles that disappeared this frame
+    };
+
+    struct ReplayAgent { // decoded state of one agent
+        double x, y, dir, speed, cost;
+        int health;
+        bool alive;
+    };
+
+    class Replay { // reads a replay file mapped into memory
+        public:
+            Replay(std::string path); // maps the file and reads its header and index
+            ~Replay();
+            bool seek(long long epoch); // go to the first frame of an epoch, false if it wasn't recorded
+            bool next(); // decode the next frame, false past the end of the epoch
+
+            bool ok; // whether the file could be read
+            int windowSize, worldWidth, worldHeight, agentSize, obstacleSize; // from the header
+            std::vector<ReplayEpoch> index;
+            long long frame; // frames decoded in the current epoch
+            std::vector<ReplayAgent> agents; // indexed by agent id
+            std::vector<std::pair<double, double>> obstacles; // positions of the obstacles of the current frame
+        private:
+            unsigned long long get(); // read one varint
+            long long getDelta(ReplayTrack& t, int k); // read a prediction error and return the value
+
+            const unsigned char* data; // the mapped file
+            size_t size;
+            const unsigned char* at; // read position
+            ReplayEpoch* current;
+            std::vector<ReplayTrack> agentTracks, obstacleTracks, nextTracks;
+    };
+};
@@ -5,8 +5,13 @@
 #include <string>
 #include <tuple>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
 
 #include "sdl.h"
+#include "sensor.h"
+#include "pool.h"
+#include "metrics.h"
 #include "constants.h"
 
 using namespace std;
@@ -38,6 +43,9 @@ SDLH::Base::Base(int w, int h, string t) {
     width = w;
     height = h;
     title = t;
+    window = NULL;
+    renderer = NULL;
+    quit = false;
 }
 
 void SDLH::Base::initBasics() {
@@ -105,23 +113,151 @@ void SDLH::Base::destroy() {
 Display
 */
 
-SDLH::Display::Display(int w, int h) : Base(w, h, "Main Display") {
+SDLH::Display::Display(int w, int h) : Base(w, h, "Main Display"), scratch(1 << 16) {
     /*
     Constructor function for Display. Uses an initializer list. 
     */
+    agentIds = 0;
+    obstacleIds = 0;
+    sensorHits = 0;
+    sensorMisses = 0;
+    ticks = 0;
+    headless = HEADLESS;
+    step = FIXED_DELTA;
+    threads = NULL;
+    metrics = NULL;
+    quality = 0;
+    tickMs = 0;
+    averageMs = 0;
+    settled = 0;
+    fill(phaseMs, phaseMs + TICK_PHASES, 0);
+    setWorld(WORLD_WIDTH > 0 ? WORLD_WIDTH : w, WORLD_HEIGHT > 0 ? WORLD_HEIGHT : h);
+}
+
+void SDLH::Display::setWorld(int w, int h) {
+    /*
+    Sets the size of the world and centers the camera on it at full size.
+    */
+    worldWidth = w;
+    worldHeight = h;
+    diagonal = sqrt((double)w * w + (double)h * h);
+    zoom = 1;
+    camX = (w - width) / 2.0;
+    camY = (h - height) / 2.0;
+}
+
+void SDLH::Display::handle(SDL_Event& e) {
+    /*
+    Moves the camera. WASD pans by a tenth of the view, + and - or the mouse
+    wheel zoom around the center of the window, and dragging with the left
+    button pans. Zooming out stops once the whole world fits.
+    */
+    double cx = camX + width / 2.0 / zoom, cy = camY + height / 2.0 / zoom;
+    if (e.type == SDL_KEYDOWN) {
+        int key = e.key.keysym.sym;
+        double step = 0.1 * width / zoom;
+        if (key == SDLK_a) cx -= step;
+        if (key == SDLK_d) cx += step;
+        if (key == SDLK_w) cy -= step;
+        if (key == SDLK_s) cy += step;
+        if (key == SDLK_EQUALS) zoom *= 1.25;
+        if (key == SDLK_MINUS) zoom /= 1.25;
+    } else if (e.type == SDL_MOUSEWHEEL) {
+        zoom *= pow(1.25, e.wheel.y);
+    } else if (e.type == SDL_MOUSEMOTION && (e.motion.state & SDL_BUTTON_LMASK)) {
+        cx -= e.motion.xrel / zoom;
+        cy -= e.motion.yrel / zoom;
+    } else {
+        return;
+    }
+    zoom = min(max(zoom, min((double)width / worldWidth, (double)height / worldHeight)), 16.0);
+    camX = cx - width / 2.0 / zoom;
+    camY = cy - height / 2.0 / zoom;
+}
+
+bool SDLH::Display::visible(double x, double y, double w, double h) {
+    return x + w >= camX && y + h >= camY && x <= camX + width / zoom && y <= camY + height / zoom;
+}
+
+float SDLH::Display::screenX(double x) {
+    return (x - camX) * zoom;
+}
+
+float SDLH::Display::screenY(double y) {
+    return (y - camY) * zoom;
+}
+
+void SDLH::Display::measureCosts() {
+    /*
+    Agents are colored by where their cost is between the lowest (or 0)
+    and the highest (or 1) cost of the frame.
+    */
+    leastCost = 0;
+    mostCost = 1;
+    for (Agent* a : agents) {
+        leastCost = min(leastCost, a->cost);
+        mostCost = max(mostCost, a->cost);
+    }
+}
+
+void SDLH::Display::line(float x1, float y1, float x2, float y2, SDL_Color c) {
+    /*
+    Queues a line as a quad half a pixel to either side of it, so lines of
+    any color can be drawn together with SDL_RenderGeometry.
+    */
+    float len = hypot(x2 - x1, y2 - y1);
+    if (len == 0) return;
+    float nx = -(y2 - y1) / len * 0.5, ny = (x2 - x1) / len * 0.5;
+    int first = vertices.size();
+    vertices.push_back({{x1 + nx, y1 + ny}, c, {0, 0}});
+    vertices.push_back({{x1 - nx, y1 - ny}, c, {0, 0}});
+    vertices.push_back({{x2 - nx, y2 - ny}, c, {0, 0}});
+    vertices.push_back({{x2 + nx, y2 + ny}, c, {0, 0}});
+    for (int i : {0, 1, 2, 0, 2, 3}) indices.push_back(first + i);
+}
+
+void SDLH::Display::render() {
+    /*
+    Submits the queued agents as one batch of triangles and the obstacles as
+    one batch of rectangles.
+    */
+    if (indices.size() > 0) {
+        SDL_RenderGeometry(renderer, NULL, vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+    if (boxes.size() > 0) {
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0x00, 0x00, 0xFF);
+        SDL_RenderFillRectsF(renderer, boxes.data(), boxes.size());
+    }
+    vertices.clear();
+    indices.clear();
+    boxes.clear();
+}
+
+SDLH::Display::~Display() {
+    /*
+    Destructor for Display.
+    */
+    for (Obstacle* o : obstacles) delete o;
+    for (Obstacle* o : pool) delete o;
+    for (TickWorker* w : workers) delete w;
+    delete threads;
 }
 
 int SDLH::Display::addAgent(Agent* a) {
     /*
     Adds an agent to the agent vector, a private data structure.
     */
+    // stagger agents so an equal share of them runs its network each tick
+    a->phase = agents.size();
+    a->id = agentIds ++;
     agents.push_back(a);
     return agents.size() - 1; // returns index
 }
 
-vector<SDLH::Agent*> SDLH::Display::getAgents() {
+const vector<SDLH::Agent*>& SDLH::Display::getAgents() {
     /*
     Gives access to the agents vector, a private data structure.
+    Returned by reference so that reading it doesn't copy it.
     */
     return agents;
 }
@@ -135,6 +271,7 @@ void SDLH::Display::clearAgents() {
     Clears the agents vector.
     */
     agents.clear();
+    agentIds = 0;
 }
 
 int SDLH::Display::addObstacle(Obstacle* o) {
@@ -145,7 +282,7 @@ int SDLH::Display::addObstacle(Obstacle* o) {
     return obstacles.size() - 1;
 }
 
-vector<SDLH::Obstacle*> SDLH::Display::getObstacles() {
+const vector<SDLH::Obstacle*>& SDLH::Display::getObstacles() {
     /*
     Gives access to a private obstacle vector.
     */
@@ -154,52 +291,363 @@ vector<SDLH::Obstacle*> SDLH::Display::getObstacles() {
 
 void SDLH::Display::clearObstacles() {
     /*
-    Clears the obstacles vector.
+    Clears the obstacles vector. The obstacles are kept to be reused.
     */
+    for (Obstacle* o : obstacles) pool.push_back(o);
     obstacles.clear();
 }
 
+SDLH::Obstacle* SDLH::Display::makeObstacle(int x, int y, real dx, real dy, Agent* creator) {
+    /*
+    Gets an obstacle, reusing one that was removed earlier if there is one
+    so that firing doesn't allocate.
+    */
+    if (pool.empty()) {
+        Obstacle* o = new Obstacle(x, y, dx, dy, this, creator);
+        o->id = obstacleIds ++;
+        return o;
+    }
+    Obstacle* o = pool.back();
+    pool.pop_back();
+    o->reset(x, y, dx, dy, creator);
+    o->id = obstacleIds ++;
+    return o;
+}
+
+void SDLH::Display::reserve() {
+    /*
+    Allocates everything a tick may need ahead of time: enough reusable obstacles
+    for every agent to fire whenever it can, room in the vectors that hold them,
+    and scratch space for every agent to sense and observe, twice over so that
+    uneven ticks fit too.
+    */
+    int most = AGENT_AMOUNT * (int)ceil(diagonal / OBSTACLE_SPEED / OBSTACLE_COOLDOWN + 1);
+    while ((int)(pool.size() + obstacles.size()) < most) {
+        pool.push_back(new Obstacle(0, 0, 0, 0, this, NULL));
+    }
+    obstacles.reserve(most);
+    pool.reserve(most);
+    delo.reserve(most);
+    dela.reserve(AGENT_AMOUNT);
+    agents.reserve(AGENT_AMOUNT);
+    // four lines per agent
+    vertices.reserve(16 * AGENT_AMOUNT);
+    indices.reserve(24 * AGENT_AMOUNT);
+    boxes.reserve(most);
+    scratch.reserve(2 * AGENT_AMOUNT * (RAY_AMOUNT + AGENT_AMOUNT + sizeof(real) * sizes[0] + 64));
+    bonuses.reserve(AGENT_AMOUNT);
+    if (THREADS > 0) {
+        // a phased tick also needs what its threads write to, and any of them may end up with every agent
+        if (threads == NULL) threads = new ThreadPool(THREADS);
+        while ((int)workers.size() < threads->size) workers.push_back(new TickWorker());
+        for (TickWorker* w : workers) {
+            w->scratch.reserve(2 * AGENT_AMOUNT * (RAY_AMOUNT + AGENT_AMOUNT + sizeof(real) * sizes[0] + 64));
+            w->spawns.reserve(AGENT_AMOUNT);
+        }
+        inputs.reserve(AGENT_AMOUNT);
+        hits.reserve(most);
+        outside.reserve(most);
+        delo.reserve(most + AGENT_AMOUNT);
+    }
+}
+
 void SDLH::Display::loop() {
     /*
     Mainloop of Display. Note that quitting Display or Debug will quit both windows at once.
     */
     if (quit) return;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    // scratch memory from the last tick is no longer used
+    scratch.reset();
     // check for multiple events
-    while (SDL_PollEvent(&e)) {
+    while (!headless && SDL_PollEvent(&e)) {
         if (e.type == SDL_QUIT) quit = true;
         // needed because SDL_QUIT will only happen if both windows are closed simultaneously.
         if (e.window.event == SDL_WINDOWEVENT_CLOSE) quit = true; 
+        handle(e);
     }
     // set background color
-    SDL_SetRenderDrawColor(renderer, 0x11, 0x11, 0x11, 0xFF);
-    SDL_RenderClear(renderer);
-    
-    for (Agent* a : agents) {
-        a->update(this);
-        a->draw(this);
+    if (!headless) {
+        SDL_SetRenderDrawColor(renderer, 0x11, 0x11, 0x11, 0xFF);
+        SDL_RenderClear(renderer);
     }
+    
+    // only what is inside the window is drawn
+    if (!headless) measureCosts();
+    if (THREADS > 0) {
+        phasedTick();
+        for (Agent* a : agents) {
+            if (!headless && visible(a->pos.first, a->pos.second, a->hitbox->w, a->hitbox->h)) a->draw(this);
+        }
+        for (Obstacle* o : obstacles) {
+            if (!headless && visible(o->pos.first, o->pos.second, o->hitbox->w, o->hitbox->h)) o->draw(this);
+        }
+    } else {
+        for (Agent* a : agents) {
+            a->update(this);
+            if (!headless && visible(a->pos.first, a->pos.second, a->hitbox->w, a->hitbox->h)) a->draw(this);
+        }
 
-    for (Obstacle* o : obstacles) {
-        o->update(this);
-        o->draw(this);
+        for (Obstacle* o : obstacles) {
+            o->update(this);
+            if (!headless && visible(o->pos.first, o->pos.second, o->hitbox->w, o->hitbox->h)) o->draw(this);
+        }
     }
     // erases objects marked for deletion
-    for (Agent* a : agents) {
-        if (dela.count(a)) {
-            agents.erase(std::remove(agents.begin(), agents.end(), a), agents.end());
-        }
+    for (Agent* a : dela) {
+        agents.erase(std::remove(agents.begin(), agents.end(), a), agents.end());
     }
-    for (Obstacle* o : obstacles) {
-        if (delo.count(o)) {
-            obstacles.erase(std::remove(obstacles.begin(), obstacles.end(), o), obstacles.end());
-        }
+    for (Obstacle* o : delo) {
+        if (find(obstacles.begin(), obstacles.end(), o) == obstacles.end()) continue;
+        obstacles.erase(std::remove(obstacles.begin(), obstacles.end(), o), obstacles.end());
+        pool.push_back(o);
     }
+    dela.clear();
+    delo.clear();
 
-    if (DEBUG_WIND) {
+    if (!headless) render();
+
+    if (DEBUG_WIND && agents.size() > 0 && quality < 1) {
         db->showNetwork(agents[0]->nn);
     }
     
-    SDL_RenderPresent(renderer);
+    if (!headless) SDL_RenderPresent(renderer);
+    ticks ++;
+    adapt(chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+    if (metrics != NULL) metrics->tick(this);
+}
+
+void SDLH::Display::adapt(double ms) {
+    /*
+    Follows a moving average of the tick time, so a single slow tick doesn't
+    change anything. A level of quality is given up when the average is over
+    TICK_BUDGET, and taken back once it is under half of it, at least 120
+    ticks after the last change so the levels don't flip back and forth at
+    the edge of the budget. Each change waits for the average to catch up
+    with the last one and is reported. Headless displays, which evaluation,
+    racing and steady-state evolution run episodes in, always stay at full
+    quality so their results don't depend on how busy the machine is.
+    */
+    tickMs = ms;
+    averageMs = ticks <= 1 ? ms : 0.75 * averageMs + 0.25 * ms;
+    if (TICK_BUDGET <= 0 || headless) return;
+    settled ++;
+    int was = quality, stride = rayStride();
+    if (settled >= 8 && averageMs > TICK_BUDGET && quality < QUALITY_LEVELS) {
+        quality ++;
+        cout << "Ticks take " << averageMs << " ms of a " << TICK_BUDGET << " ms budget, " << qualityName(quality) << "\n";
+    } else if (settled >= 120 && averageMs < TICK_BUDGET / 2 && quality > 0) {
+        cout << "Ticks take " << averageMs << " ms of a " << TICK_BUDGET << " ms budget, no longer " << qualityName(quality) << "\n";
+        quality --;
+    }
+    if (quality == was) return;
+    settled = 0;
+    // cached readings of rays that were copied from others aren't real readings
+    if (rayStride() != stride) {
+        for (Agent* a : agents) a->sensor->invalidate();
+    }
+}
+
+const char* SDLH::qualityName(int level) {
+    const char* names[QUALITY_LEVELS + 1] = {
+        "at full quality",
+        "skipping the debug window",
+        "comparing agents with every other one for novelty",
+        "running networks half as often",
+        "casting every other ray",
+        "casting every fourth ray"
+    };
+    return level >= 0 && level <= QUALITY_LEVELS ? names[level] : "";
+}
+
+double SDLH::Display::delta(Uint32 since) {
+    /*
+    A fixed step if there is one, otherwise the real time elapsed. With
+    TICK_BUDGET set a late tick of a display that is shown moves things by
+    at most a budget's worth, so the world slows down for a moment instead
+    of jumping.
+    */
+    if (step > 0) return step;
+    double d = max((SDL_GetTicks() - since) / 5.0, 0.01);
+    if (TICK_BUDGET > 0 && !headless) d = min(d, TICK_BUDGET / 5.0);
+    return d;
+}
+
+int SDLH::Display::rayStride() {
+    return quality >= 5 ? 4 : (quality >= 4 ? 2 : 1);
+}
+
+int SDLH::Display::controlRate() {
+    return quality >= 3 ? 2 * CONTROL_RATE : CONTROL_RATE;
+}
+
+int SDLH::Display::noveltyStride() {
+    return quality >= 2 ? 2 : 1;
+}
+
+double SDLH::Display::reward() {
+    /*
+    Gives the rewards that depend on every agent for this tick: a novelty
+    bonus for acting differently from the others, and a proximity reward
+    for getting close to another agent. Returns the largest novelty bonus.
+    Each agent only reads the others and writes its own cost, so with
+    THREADS set the agents are split over the pool with the same results.
+    */
+    bonuses.resize(agents.size());
+    int every = noveltyStride();
+    auto give = [this, every] (int k, int w) {
+        Agent* a = agents[k];
+        // novelty bonus, from a share of the others that changes every tick when lowering quality
+        double bonus = 0;
+        for (int j = (k + ticks) % every; j < (int)agents.size(); j += every) {
+            Agent* o = agents[j];
+            if (a == o) {
+                continue;
+            }
+            double add = 0;
+            for (int i = 0; i < a->action.size(); i ++) {
+                add += pow((a->action[i] - o->action[i]), 2);
+            }
+            bonus += sqrt(add);
+        }
+        bonus *= every;
+        a->charge(NOVELTY_PART, -bonus * NOVELTY_REWARD);
+        bonuses[k] = bonus;
+        // proximity reward
+        double closest = PROXIMITY_RADIUS;
+        for (Agent* o : agents) {
+            if (o == a) {
+                continue;
+            }
+            double dist = sqrt(pow((a->pos.first - o->pos.first), 2) + pow((a->pos.second - o->pos.second), 2));
+            closest = min(closest, dist);
+        }
+        a->charge(PROXIMITY_PART, -((PROXIMITY_RADIUS - closest) / PROXIMITY_RADIUS) * PROXIMITY_REWARD);
+    };
+    if (THREADS > 0 && threads != NULL) {
+        threads->run(agents.size(), give);
+    } else {
+        for (int k = 0; k < (int)agents.size(); k ++) give(k, 0);
+    }
+    double mxb = 0;
+    for (double bonus : bonuses) mxb = max(mxb, bonus);
+    return mxb;
+}
+
+void SDLH::Display::phasedTick() {
+    /*
+    Updates agents and obstacles in phases, each spread over the thread pool:
+    sense, where every agent reads the world as the last tick left it; infer;
+    integrate, where every agent moves itself; collide; and score. Within a
+    phase a thread only writes to the agent or obstacle it is working on or to
+    its own TickWorker, and whatever several of them produce is merged in a
+    fixed order afterwards, so the results are the same for any THREADS.
+    */
+    if (threads == NULL || (int)workers.size() < threads->size) reserve();
+    chrono::steady_clock::time_point mark = chrono::steady_clock::now();
+    int phase = 0;
+    // adds the time since the last call to the current phase and moves on to the next
+    auto lap = [this, &mark, &phase] () {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        phaseMs[phase ++] = chrono::duration<double, milli>(now - mark).count();
+        mark = now;
+    };
+    senseChannels(); // parsed here so the threads only ever read it
+    // the dead leave before anyone senses them
+    agents.erase(remove_if(agents.begin(), agents.end(), [] (Agent* a) { return a->health <= 0; }), agents.end());
+    int n = agents.size();
+    for (TickWorker* w : workers) {
+        w->scratch.reset();
+        w->spawns.clear();
+    }
+
+    // sense
+    inputs.assign(n, (real*)NULL);
+    auto sense = [this] (int i, int w) {
+        Agent* a = agents[i];
+        if (!a->due(this)) return;
+        inputs[i] = workers[w]->scratch.alloc<real>(a->nn->layers[0]->neurons.size());
+        a->observe(this, inputs[i], workers[w]);
+    };
+    threads->run(n, sense);
+    lap();
+
+    // infer
+    auto infer = [this] (int i, int w) {
+        if (inputs[i] == NULL) return;
+        Agent* a = agents[i];
+        AIH::Layer* inp = a->nn->layers[0];
+        for (int v = 0; v < inp->neurons.size(); v ++) {
+            inp->neurons[v]->value = inputs[i][v];
+        }
+        a->action = a->nn->run();
+    };
+    threads->run(n, infer);
+    lap();
+
+    // integrate, shots wait in the queue of the thread that fired them
+    auto integrate = [this] (int i, int w) {
+        agents[i]->move(this, workers[w]);
+    };
+    threads->run(n, integrate);
+    // agents are kept in order of id, so this adds the shots in the order a sequential tick would
+    int queued = 0;
+    for (TickWorker* w : workers) queued += w->spawns.size();
+    Spawn* spawned = scratch.alloc<Spawn>(queued);
+    int k = 0;
+    for (TickWorker* w : workers) {
+        for (Spawn& s : w->spawns) spawned[k ++] = s;
+    }
+    sort(spawned, spawned + queued, [] (const Spawn& x, const Spawn& y) { return x.creator->id < y.creator->id; });
+    for (int i = 0; i < queued; i ++) {
+        Spawn& s = spawned[i];
+        addObstacle(makeObstacle(s.x, s.y, s.dx, s.dy, s.creator));
+    }
+    lap();
+
+    // collide: obstacles count the agents they hit and agents count what hit them, so nobody writes to another
+    int m = obstacles.size();
+    hits.assign(m, 0);
+    outside.assign(m, 0);
+    auto fly = [this] (int i, int w) {
+        Obstacle* o = obstacles[i];
+        outside[i] = o->move(this);
+        for (Agent* a : agents) {
+            if (o->creator != a && collision(a->hitbox, o->hitbox)) hits[i] ++;
+        }
+    };
+    threads->run(m, fly);
+    auto struck = [this] (int i, int w) {
+        Agent* a = agents[i];
+        for (Obstacle* o : obstacles) {
+            if (o->creator == a || !collision(a->hitbox, o->hitbox)) continue;
+            a->charge(STRUCK_PART, HIT_COST);
+            a->health --;
+        }
+    };
+    threads->run(n, struck);
+    lap();
+
+    // score: shooters are rewarded in obstacle order, since any agent may have fired several of them
+    for (int i = 0; i < m; i ++) {
+        for (int k = 0; k < hits[i]; k ++) obstacles[i]->creator->charge(HIT_PART, HIT_REWARD);
+        if (hits[i] > 0 || outside[i]) delo.push_back(obstacles[i]);
+    }
+    for (TickWorker* w : workers) {
+        sensorHits += w->sensorHits;
+        sensorMisses += w->sensorMisses;
+        w->sensorHits = 0;
+        w->sensorMisses = 0;
+    }
+    lap();
+}
+
+double SDLH::Display::sensorHitRate() {
+    /*
+    Gets the fraction of ray readings that sensor caches reused instead of recasting.
+    */
+    if (sensorHits + sensorMisses == 0) return 0;
+    return (double)sensorHits / (sensorHits + sensorMisses);
 }
 
 void SDLH::Display::createDebug() {
@@ -301,11 +749,13 @@ void SDLH::Debug::showNetwork(AIH::Network* nn) {
             
             // add edges
             for (int k = 0; k < l->neurons[j]->weights.size(); k ++) {
+                // pruned connections aren't drawn
+                if (nn->sparse && n->weights[k] == 0) continue;
                 // gets the difference in the value the edge causes.
                 double nval = nn->layers[i + 1]->neurons[k]->value; // next layer's val
                 double change = n->weights[k] * n->value; // what this weight adds to the wsum
                 double before = log(1 + nval / 1 - nval) / 2; // the value before the sigmoid function
-                auto color = redgreen(nval - AIH::accs(before - change)); 
+                auto color = redgreen(nval - AIH::activation(nn->layers[i + 1]->act, before - change)); 
                 
                 // set draw color to difference in value edge causes
                 SDL_SetRenderDrawColor(renderer, get<0>(color), get<1>(color), get<2>(color), 0xFF);
@@ -336,11 +786,27 @@ tuple<int, int, int> SDLH::Debug::redgreen(double val) {
 Obstacle
 */
 
-SDLH::Obstacle::Obstacle(int x, int y, double dx, double dy, SDLH::Display* b, SDLH::Agent* creator) {
+SDLH::Obstacle::Obstacle(int x, int y, real dx, real dy, SDLH::Display* b, SDLH::Agent* creator) {
     /*
     Constructor for Obstacles which will increase the cost of agents it intersects with. 
     */
     hitbox = new SDL_Rect();
+    id = -1;
+    reset(x, y, dx, dy, creator);
+    b->rects.push_back(hitbox);
+}
+
+SDLH::Obstacle::~Obstacle() {
+    /*
+    Destructor for Obstacle.
+    */
+    delete hitbox;
+}
+
+void SDLH::Obstacle::reset(int x, int y, real dx, real dy, SDLH::Agent* creator) {
+    /*
+    Puts the obstacle back at its starting state so it can be reused.
+    */
     hitbox->x = x;
     hitbox->y = y;
     hitbox->h = OBSTACLE_SIZE;
@@ -350,51 +816,59 @@ SDLH::Obstacle::Obstacle(int x, int y, double dx, double dy, SDLH::Display* b, S
     this->dy = dy;
     this->creator = creator;
     starttick = SDL_GetTicks();
-    b->rects.push_back(hitbox);
 }
 
 void SDLH::Obstacle::update(SDLH::Display* b) {
     /*
     Moves the obstacle and checks for any hits.
     */
+    bool hit = move(b);
+    // check for collisions
+    for (SDLH::Agent* ag : b->getAgents()) {
+        if (creator == ag) continue;
+        if (collision(ag->hitbox, hitbox)) {
+            ag->charge(STRUCK_PART, HIT_COST);
+            creator->charge(HIT_PART, HIT_REWARD);
+            ag->health --;
+            hit = true;
+        }
+    }
+    if (hit) {
+        b->delo.push_back(this);
+    }
+}
+
+bool SDLH::Obstacle::move(SDLH::Display* b) {
+    /*
+    Moves the obstacle along its velocity.
+    */
     bool hit = false;
     // find delta and update ticks
-    double delta = max((SDL_GetTicks() - starttick) / 5.0, 0.01);
+    real delta = b->delta(starttick);
     starttick = SDL_GetTicks();
     // find new positions
-    double ny = pos.second + dy * delta;
-    double nx = pos.first + dx * delta;
+    real ny = pos.second + dy * delta;
+    real nx = pos.first + dx * delta;
     // move back in bounds if out of bounds
     if (ny < 0) hit = true;
     if (nx < 0) hit = true;
-    if (nx > b->width) hit = true;
-    if (ny > b->height) hit = true;
-    if (ny < 0 || nx < 0 || nx > b->width || ny > b->height) hit = true;
+    if (nx > b->worldWidth) hit = true;
+    if (ny > b->worldHeight) hit = true;
+    if (ny < 0 || nx < 0 || nx > b->worldWidth || ny > b->worldHeight) hit = true;
     // update internal positions
     pos.first = nx;
     pos.second = ny;
     // update hitbox positions
     hitbox->x = pos.first;
     hitbox->y = pos.second;
-    // check for collisions
-    auto ags = b->getAgents();
-    for (SDLH::Agent* ag : ags) {
-        if (creator == ag) continue;
-        if (collision(ag->hitbox, hitbox)) {
-            ag->cost += HIT_COST;
-            creator->cost += HIT_REWARD;
-            ag->health --;
-            hit = true;
-        }
-    }
-    if (hit) {
-        b->delo.insert(this);
-    }
+    return hit;
 }
 
 void SDLH::Obstacle::draw(SDLH::Display* b) {
-    SDL_SetRenderDrawColor(b->renderer, 0xFF, 0x00, 0x00, 0xFF);
-    SDL_RenderFillRect(b->renderer, hitbox);
+    /*
+    Queues the obstacle, the display draws them all at once.
+    */
+    b->boxes.push_back({b->screenX(hitbox->x), b->screenY(hitbox->y), (float)(hitbox->w * b->zoom), (float)(hitbox->h * b->zoom)});
 }
 
 /*
@@ -407,26 +881,60 @@ SDLH::Agent::Agent(int x, int y, double dir, int side, SDLH::Display* b) {
     */
     // hitbox configuration
     hitbox = new SDL_Rect();
-    hitbox->x = x;
-    hitbox->y = y;
     hitbox->w = AGENT_SIZE;
     hitbox->h = AGENT_SIZE;
+    this->side = side; // ai faction
+    nn = new AIH::Network(); // neural network
+    b->rects.push_back(this->hitbox);
+    fan = new RayFan();
+    sensor = new SensorCache();
+    phase = 0;
+    id = 0;
+    external = false;
+    respawn(x, y, dir);
+}
+
+SDLH::Agent::~Agent() {
+    /*
+    Destructor for Agent. Frees everything the agent made.
+    */
+    delete hitbox;
+    delete nn;
+    delete fan;
+    delete sensor;
+}
+
+void SDLH::Agent::respawn(int x, int y, double dir) {
+    /*
+    Puts the agent at a position with its starting state, keeping its network.
+    */
+    hitbox->x = x;
+    hitbox->y = y;
     pos = {x, y}; // set position
     speed = 0; // initialize speed
+    angvel = 0;
     this->dir = dir; // initialize direction
-    this->side = side; // ai faction
     this->health = AGENT_HEALTH;
-    nn = new AIH::Network(); // neural network
     starttick = SDL_GetTicks(); // for use to calculate delta
     cost = 0;
-    b->rects.push_back(this->hitbox);
+    fill(parts, parts + COST_PARTS, 0);
     cooldown = OBSTACLE_COOLDOWN;
-    for (int i = 0; i < RAY_AMOUNT; i ++) {
-        double nang = (dir - (SIGHT_ANGLE / 2) + (i + 1) * (SIGHT_ANGLE / (RAY_AMOUNT + 1)));
-        nang -= (int)(nang / 360) * 360;
-        if (nang < 0) nang += 360;
-        rays.push_back(new Ray(x, y, nang, b));
-    }
+    action.clear();
+    fan->aim(x, y, dir);
+    sensor->invalidate();
+}
+
+void SDLH::Agent::observe(SDLH::Display* b, real* out, SDLH::TickWorker* w) {
+    /*
+    Writes what the agent senses into out, in the order of the network's
+    input layer: one reading per ray of each channel, then speed and angular
+    velocity.
+    */
+    // recasting only the rays the sensor cache can't reuse
+    sensor->sense(this, b, out, w);
+    int rays = senseChannels().size() * RAY_AMOUNT;
+    out[rays] = (speed + MAX_SPEED) / (2 * MAX_SPEED);
+    out[rays + 1] = (angvel + MAX_ANGVEL) / (2 * MAX_ANGVEL);
 }
 
 void getInputs(AIH::Network* &nn, SDLH::Agent* a, SDLH::Display* b) {
@@ -435,21 +943,11 @@ void getInputs(AIH::Network* &nn, SDLH::Agent* a, SDLH::Display* b) {
     */
     AIH::Layer* inp = nn->layers[0];
     // set inputs
-    vector<SDLH::Agent*> agents = b->getAgents();
-    for (int i = 0; i < RAY_AMOUNT; i ++) {
-        double nang = ((a->dir) - (SIGHT_ANGLE / 2) + (i + 1) * (SIGHT_ANGLE / (RAY_AMOUNT + 1)));
-        nang -= (int)(nang / 360) * 360;
-        if (nang < 0) nang += 360;
-        (a->rays[i])->update(a->pos.first, a->pos.second, nang);
-        double cur = a->rays[i]->agint(agents, a);
-        if (cur == 1e9) {
-            inp->neurons[i]->value = 1; 
-        } else {
-            inp->neurons[i]->value = cur / (WINDOW_SIZE * sqrt(2)); // longest possible length
-        }
+    AIH::real* obs = b->scratch.alloc<AIH::real>(inp->neurons.size());
+    a->observe(b, obs);
+    for (int i = 0; i < inp->neurons.size(); i ++) {
+        inp->neurons[i]->value = obs[i];
     }
-    inp->neurons[RAY_AMOUNT]->value = (a->speed + MAX_SPEED) / (2 * MAX_SPEED);
-    inp->neurons[RAY_AMOUNT + 1]->value = (a->angvel + MAX_ANGVEL) / (2 * MAX_ANGVEL);
 }
 
 void SDLH::Agent::update(SDLH::Display* b) {
@@ -461,18 +959,38 @@ void SDLH::Agent::update(SDLH::Display* b) {
         // delete this;
         b->removeAgent(this);
     }
-    // changes inputs
-    getInputs(nn, this, b);
-    // runs nn
-    vector<double> a = nn->run();
+    if (due(b)) {
+        // changes inputs
+        getInputs(nn, this, b);
+        // runs nn
+        action = nn->run();
+    }
+    move(b);
+}
+
+bool SDLH::Agent::due(SDLH::Display* b) {
+    /*
+    Only evaluates the policy every CONTROL_RATE ticks, or twice that when
+    the display has lowered its quality, repeating the last action in
+    between. Agents controlled from outside have their action set for them.
+    */
+    return !external && (action.empty() || (b->ticks + phase) % b->controlRate() == 0);
+}
+
+void SDLH::Agent::move(SDLH::Display* b, SDLH::TickWorker* w) {
+    /*
+    Applies the current action: turns, moves and fires.
+    */
+    const vector<real>& a = action;
+    real most = MAX_ANGVEL, fastest = MAX_SPEED;
     // sets angvel and speed based on outputs
     // angvel = a[1] - dir;
-    angvel = 2 * (a[1] - 0.5) * MAX_ANGVEL;
-    speed = a[0] * MAX_SPEED;
+    angvel = 2 * (a[1] - (real)0.5) * most;
+    speed = a[0] * fastest;
     // cout << a[0] << " " << a[1] << "\n";
     // applies constraints
-    angvel = max(min(angvel, MAX_ANGVEL), MAX_ANGVEL * -1);
-    speed = max(min(speed, MAX_SPEED), MAX_SPEED * -1);
+    angvel = max(min(angvel, most), most * -1);
+    speed = max(min(speed, fastest), fastest * -1);
     if (abs(speed) < 0.1) {
         speed = 0;
     }
@@ -484,60 +1002,54 @@ void SDLH::Agent::update(SDLH::Display* b) {
     if (dir < 0) {
         dir += 360;
     }
-    double dec = dir - floor(dir);
+    real dec = dir - floor(dir);
     dir = (int)dir % 360 + dec;
     // find delta and update ticks
-    double delta = max((SDL_GetTicks() - starttick) / 5.0, 0.01);
+    real delta = b->delta(starttick);
     starttick = SDL_GetTicks();
     // find new positions
-    double ny = pos.second - sin(dir * M_PI / 180) * speed * delta;
-    double nx = pos.first + cos(dir * M_PI / 180) * speed * delta;
+    real ny = pos.second - sin(dir * (real)M_PI / 180) * speed * delta;
+    real nx = pos.first + cos(dir * (real)M_PI / 180) * speed * delta;
     // move back in bounds if out of bounds
-    if (ny < 0) ny += b->height;
-    if (nx < 0) nx += b->width;
-    if (nx > b->width) nx -= b->width;
-    if (ny > b->height) ny -= b->height;
+    if (ny < 0) ny += b->worldHeight;
+    if (nx < 0) nx += b->worldWidth;
+    if (nx > b->worldWidth) nx -= b->worldWidth;
+    if (ny > b->worldHeight) ny -= b->worldHeight;
     // update internal positions
     pos.first = nx;
     pos.second = ny;
     // update hitbox positions
     hitbox->x = pos.first;
     hitbox->y = pos.second;
-    // readjusts rays
-    for (int i = 0; i < RAY_AMOUNT; i ++) {
-        double nang = (dir - (SIGHT_ANGLE / 2) + (i + 1) * (SIGHT_ANGLE / (RAY_AMOUNT + 1)));
-        nang -= (int)(nang / 360) * 360;
-        if (nang < 0) nang += 360;
-        rays[i]->update(pos.first, pos.second, nang);
-    }
+    // readjusts rays, which stay aimed until the next update
+    fan->aim(pos.first, pos.second, dir);
     // fires obstacles
     if (a[2] >= 0.5) {
-        fire(b, dir);
+        fire(b, dir, w);
     }
-    cooldown = max(0.0, cooldown - delta);
+    cooldown = max((real)0, cooldown - delta);
 }
 
 void SDLH::Agent::draw(SDLH::Display* b) { 
     /*
-    Draws the agent texture onto the screen.
+    Queues the agent's outline, the display draws them all at once. The
+    cost range comes from Display::measureCosts, which runs before the
+    tick's costs are charged, so an agent can end up outside of it.
     */
+    SDL_Color c = {0xFF, 0xFF, 0xFF, 0xFF};
     if (SHOW_COSTS) {
-        double most = 1;
-        double least = 0;
-        for (Agent* a : b->getAgents()) {
-            most = max(most, a->cost);
-            least = min(least, a->cost);
-        }
-        SDL_SetRenderDrawColor(b->renderer, 255 * ((cost - least)/(most)), 255 - 255 * ((cost - least)/(most)), 0x00, 0xFF);
-    } else {
-        SDL_SetRenderDrawColor(b->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        double f = (cost - b->leastCost) / (b->mostCost - b->leastCost);
+        f = min(max(f, 0.0), 1.0);
+        c = {(Uint8)(255 * f), (Uint8)(255 - 255 * f), 0x00, 0xFF};
     }
-    auto rotate = [] (pair<float, float> p, pair<float, float> r, double angle) -> pair<float, float> {
+    // every corner turns by the same angle, so its sine and cosine are found once
+    double rad = (90 - dir) * (M_PI / 180);
+    double cs = cos(rad), sn = sin(rad);
+    auto rotate = [cs, sn] (pair<float, float> p, pair<float, float> r) -> pair<float, float> {
         float x = p.first, y = p.second, rx = r.first, ry = r.second;
         x -= rx; y -= ry;
-        double rad = angle * (M_PI / 180);
-        int cx = x * cos(rad) - y * sin(rad);
-        int cy = y * cos(rad) + x * sin(rad);
+        int cx = x * cs - y * sn;
+        int cy = y * cs + x * sn;
         return make_pair(cx + rx, cy + ry);
     };
     float x1 = pos.first, 
@@ -546,37 +1058,312 @@ void SDLH::Agent::draw(SDLH::Display* b) {
     y2 = y1 + hitbox->h;
     pair<float, float> midp = make_pair((x1 + x2) / 2, y1 + (y2 - y1) / 2);
     pair<float, float> top = make_pair((x1 + x2) / 2, y1);
-    top = rotate(top, midp, 90 - dir);
+    top = rotate(top, midp);
     pair<float, float> left = make_pair(x1, y2);
-    left = rotate(left, midp, 90 - dir);
+    left = rotate(left, midp);
     pair<float, float> right = make_pair(x2, y2);
-    right = rotate(right, midp, 90 - dir);
+    right = rotate(right, midp);
     pair<float, float> down = make_pair((x1 + x2) / 2, y1 + (y2 - y1) / 2);
-    down = rotate(down, midp, 90 - dir);
-    SDL_RenderDrawLineF(b->renderer, top.first, top.second, left.first, left.second);
-    SDL_RenderDrawLineF(b->renderer, top.first, top.second, right.first, right.second);
-    SDL_RenderDrawLineF(b->renderer, down.first, down.second, left.first, left.second);
-    SDL_RenderDrawLineF(b->renderer, down.first, down.second, right.first, right.second);
+    down = rotate(down, midp);
+    // from the world onto the window
+    for (pair<float, float>* p : {&top, &left, &right, &down}) {
+        *p = make_pair(b->screenX(p->first), b->screenY(p->second));
+    }
+    b->line(top.first, top.second, left.first, left.second, c);
+    b->line(top.first, top.second, right.first, right.second, c);
+    b->line(down.first, down.second, left.first, left.second, c);
+    b->line(down.first, down.second, right.first, right.second, c);
+}
+
+void SDLH::Agent::charge(CostPart part, double amount) {
+    cost += amount;
+    parts[part] += amount;
+}
+
+const char* SDLH::costPartName(int part) {
+    const char* names[COST_PARTS] = {"fire", "struck", "hit", "novelty", "proximity"};
+    return part >= 0 && part < COST_PARTS ? names[part] : "";
 }
 
 double SDLH::Agent::getRay(SDLH::Display* b, double dir, vector<SDL_Rect*> boxes) {
     return 1;
 }
 
-void SDLH::Agent::fire(SDLH::Display* b, double dir) {
+void SDLH::Agent::fire(SDLH::Display* b, real dir, SDLH::TickWorker* w) {
     if (cooldown > 0) return; 
-    cost += FIRE_COST;
+    charge(FIRE_PART, FIRE_COST);
     cooldown = OBSTACLE_COOLDOWN;
-    double dx = cos(dir * M_PI / 180) * OBSTACLE_SPEED;
-    double dy = -1 * sin(dir * M_PI / 180) * OBSTACLE_SPEED;
-    b->addObstacle(new Obstacle(pos.first, pos.second, dx, dy, b, this));
+    real dx = cos(dir * (real)M_PI / 180) * OBSTACLE_SPEED;
+    real dy = -1 * sin(dir * (real)M_PI / 180) * OBSTACLE_SPEED;
+    if (w != NULL) {
+        w->spawns.push_back({pos.first, pos.second, dx, dy, this});
+        return;
+    }
+    b->addObstacle(b->makeObstacle(pos.first, pos.second, dx, dy, this));
+}
+
+/*
+TickWorker
+*/
+
+SDLH::TickWorker::TickWorker() : scratch(1 << 16) {
+    /*
+    Constructor for TickWorker.
+    */
+    sensorHits = 0;
+    sensorMisses = 0;
+}
+
+/*
+RayFan
+*/
+
+double SDLH::rayOffset(int i) {
+    /*
+    Angle of the i-th ray relative to the agent's direction in degrees.
+    */
+    return - (SIGHT_ANGLE / 2.0) + (i + 1) * (SIGHT_ANGLE / (RAY_AMOUNT + 1.0));
+}
+
+const vector<SDLH::Channel>& SDLH::senseChannels() {
+    /*
+    Parses SENSE_CHANNELS, which parseArgs has already checked. The result
+    is kept until SENSE_CHANNELS changes, so this is cheap to call every tick.
+    */
+    static string parsed = "";
+    static vector<Channel> channels = {AGENT_CHANNEL};
+    if (parsed != SENSE_CHANNELS) {
+        parsed = SENSE_CHANNELS;
+        channels.clear();
+        size_t start = 0;
+        while (start <= parsed.size()) {
+            size_t end = min(parsed.find(',', start), parsed.size());
+            string name = parsed.substr(start, end - start);
+            if (name == "agents") channels.push_back(AGENT_CHANNEL);
+            if (name == "obstacles") channels.push_back(OBSTACLE_CHANNEL);
+            if (name == "walls") channels.push_back(WALL_CHANNEL);
+            start = end + 1;
+        }
+    }
+    return channels;
+}
+
+vector<AIH::real> offcos, offsin; // unit vectors of each ray offset, shared by every fan
+double offstart, offstep; // offset of the first ray and the angle between rays
+
+void SDLH::prepareShared() {
+    /*
+    senseChannels and the ray offsets of RayFan are made the first time
+    they are needed, which threads making agents at once would race on.
+    */
+    senseChannels();
+    RayFan warm;
+}
+
+SDLH::RayFan::RayFan() {
+    /*
+    Constructor for RayFan. The first fan made also works out the unit
+    vectors of the ray offsets that every fan rotates.
+    */
+    if ((int)offcos.size() != RAY_AMOUNT) {
+        offcos.clear();
+        offsin.clear();
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            offcos.push_back(cos(rayOffset(i) * M_PI / 180));
+            offsin.push_back(sin(rayOffset(i) * M_PI / 180));
+        }
+        offstart = rayOffset(0);
+        offstep = rayOffset(1) - rayOffset(0);
+    }
+    x = 0;
+    y = 0;
+    dir = 0;
+    dx = vector<real> (RAY_AMOUNT, 0);
+    dy = vector<real> (RAY_AMOUNT, 0);
+}
+
+void SDLH::RayFan::aim(real x, real y, real dir) {
+    /*
+    Points every ray by rotating the offsets by dir, so only one sine and
+    cosine are computed per agent. Angles go counterclockwise while y points
+    down, so the y component is flipped.
+    */
+    this->x = x;
+    this->y = y;
+    this->dir = dir;
+    real c = cos(dir * (real)M_PI / 180), s = sin(dir * (real)M_PI / 180);
+    for (int i = 0; i < RAY_AMOUNT; i ++) {
+        dx[i] = c * offcos[i] - s * offsin[i];
+        dy[i] = -(s * offcos[i] + c * offsin[i]);
+    }
+}
+
+SDLH::real SDLH::RayFan::hit(int i, SDL_Rect* hitbox) {
+    /*
+    Slab test of ray i against a hitbox. Returns the distance to where the
+    ray enters it, or to where it leaves it if the ray starts inside.
+    */
+    real x1 = hitbox->x, y1 = hitbox->y;
+    real x2 = x1 + hitbox->w, y2 = y1 + hitbox->h;
+    real tmin = -1e18, tmax = 1e18;
+    if (dx[i] != 0) {
+        real a = (x1 - x) / dx[i], b = (x2 - x) / dx[i];
+        tmin = max(tmin, min(a, b));
+        tmax = min(tmax, max(a, b));
+    } else if (x < x1 || x > x2) {
+        return 1e9;
+    }
+    if (dy[i] != 0) {
+        real a = (y1 - y) / dy[i], b = (y2 - y) / dy[i];
+        tmin = max(tmin, min(a, b));
+        tmax = min(tmax, max(a, b));
+    } else if (y < y1 || y > y2) {
+        return 1e9;
+    }
+    if (tmax < 0 || tmin > tmax) return 1e9;
+    return tmin >= 0 ? tmin : tmax;
+}
+
+void SDLH::RayFan::project(SDL_Rect* hitbox, int id, const char* which, real* r, int* ids, int every) {
+    /*
+    Depth buffer version of testing every ray against a hitbox. The hitbox
+    is bounded by a circle, which covers an angle of asin(radius / distance)
+    to each side of its center as seen from the fan, and only the rays
+    inside that span are tested with hit, so a far away hitbox costs one
+    or two rays however many there are. The bound is padded by a pixel and
+    the rays it covers get the exact slab test, so the distances are the
+    same as testing every ray.
+    */
+    double cx = hitbox->x + hitbox->w / 2.0, cy = hitbox->y + hitbox->h / 2.0;
+    double radius = hypot(hitbox->w, hitbox->h) / 2 + 1;
+    double dist = hypot(cx - x, cy - y);
+    int first = 0, last = RAY_AMOUNT - 1;
+    // without any room between rays every ray is where the first one is
+    bool all = dist <= radius || offstep <= 0;
+    // same angle convention as the rays: counterclockwise with y pointing down
+    double center = atan2(-(cy - y), cx - x) * 180 / M_PI - dir;
+    center -= 360 * floor((center + 180) / 360);
+    double half = all ? 0 : asin(radius / dist) * 180 / M_PI;
+    // with a wide SIGHT_ANGLE the span can also show up a turn to either side
+    for (int turn = -360; turn <= 360; turn += 360) {
+        if (!all) {
+            first = max((int)ceil((center + turn - half - offstart) / offstep), 0);
+            last = min((int)floor((center + turn + half - offstart) / offstep), RAY_AMOUNT - 1);
+        }
+        for (int i = first; i <= last; i ++) {
+            if ((which != NULL && !which[i]) || i % every != 0) continue;
+            real d = hit(i, hitbox);
+            if (d < r[i]) {
+                r[i] = d;
+                ids[i] = id;
+            }
+        }
+        if (all) return;
+    }
+}
+
+void SDLH::RayFan::cast(Display* b, Agent* avoid, const char* which, real* res, int* ids) {
+    /*
+    Casts the fan against every channel in one pass. Channel c of ray i is
+    stored at c * RAY_AMOUNT + i: the distance to the closest thing it sees
+    in res, or 1e9 if there is none, and that thing's id in ids, or -1.
+    Only the agent rays with which[i] set are recast, since those are the
+    ones the sensor cache can't reuse; obstacles move every tick and walls
+    cost one division, so those rays are always cast. Things are the outer
+    loop so each hitbox is read once and then tested against the whole fan,
+    or with DEPTH_SENSING only against the rays it covers (see project).
+    A display that lowered its quality only casts every rayStride rays, and
+    the rays in between copy the reading of the last one cast.
+    */
+    const vector<Channel>& channels = senseChannels();
+    int every = b->rayStride();
+    for (int c = 0; c < (int)channels.size(); c ++) {
+        real* r = res + c * RAY_AMOUNT;
+        int* id = ids + c * RAY_AMOUNT;
+        if (channels[c] == AGENT_CHANNEL) {
+            for (int i = 0; i < RAY_AMOUNT; i ++) {
+                if (!which[i]) continue;
+                r[i] = 1e9;
+                id[i] = -1;
+            }
+            for (Agent* a : b->getAgents()) {
+                if (a == avoid) continue;
+                if (DEPTH_SENSING) {
+                    project(a->hitbox, a->id, which, r, id, every);
+                    continue;
+                }
+                for (int i = 0; i < RAY_AMOUNT; i += every) {
+                    if (!which[i]) continue;
+                    real d = hit(i, a->hitbox);
+                    if (d < r[i]) {
+                        r[i] = d;
+                        id[i] = a->id;
+                    }
+                }
+            }
+        } else if (channels[c] == OBSTACLE_CHANNEL) {
+            fill(r, r + RAY_AMOUNT, 1e9);
+            fill(id, id + RAY_AMOUNT, -1);
+            for (Obstacle* o : b->getObstacles()) {
+                if (o->creator == avoid) continue;
+                if (DEPTH_SENSING) {
+                    project(o->hitbox, o->id, NULL, r, id, every);
+                    continue;
+                }
+                for (int i = 0; i < RAY_AMOUNT; i += every) {
+                    real d = hit(i, o->hitbox);
+                    if (d < r[i]) {
+                        r[i] = d;
+                        id[i] = o->id;
+                    }
+                }
+            }
+        } else {
+            for (int i = 0; i < RAY_AMOUNT; i += every) {
+                // the first edge of the display the ray reaches
+                real tx = dx[i] > 0 ? (b->worldWidth - x) / dx[i] : (dx[i] < 0 ? -x / dx[i] : (real)1e9);
+                real ty = dy[i] > 0 ? (b->worldHeight - y) / dy[i] : (dy[i] < 0 ? -y / dy[i] : (real)1e9);
+                r[i] = max(min(tx, ty), (real)0);
+                id[i] = tx <= ty ? (dx[i] > 0 ? 2 : 0) : (dy[i] > 0 ? 3 : 1);
+            }
+        }
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            if (i % every == 0) continue;
+            r[i] = r[i - i % every];
+            id[i] = id[i - i % every];
+        }
+    }
+    if (SHOW_RAYS && !b->headless) {
+        // each ray is drawn up to the closest thing it sees, colored by its channel
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            double d = 1e9;
+            int seen = -1;
+            for (int c = 0; c < (int)channels.size(); c ++) {
+                if (res[c * RAY_AMOUNT + i] < d) {
+                    d = res[c * RAY_AMOUNT + i];
+                    seen = channels[c];
+                }
+            }
+            if (seen == AGENT_CHANNEL) {
+                SDL_SetRenderDrawColor(b->renderer, 0x00, 0xFF, 0x00, 0xFF);
+            } else if (seen == OBSTACLE_CHANNEL) {
+                SDL_SetRenderDrawColor(b->renderer, 0xFF, 0x88, 0x00, 0xFF);
+            } else if (seen == WALL_CHANNEL) {
+                SDL_SetRenderDrawColor(b->renderer, 0x44, 0x66, 0xFF, 0xFF);
+            } else {
+                SDL_SetRenderDrawColor(b->renderer, 0x66, 0x66, 0x66, 0x55);
+                d = b->diagonal;
+            }
+            SDL_RenderDrawLineF(b->renderer, b->screenX(x), b->screenY(y), b->screenX(x + dx[i] * d), b->screenY(y + dy[i] * d));
+        }
+    }
 }
 
 /*
 Ray
 */
 
-SDLH::Ray::Ray(double x, double y, double ang, SDLH::Display* b) {
+SDLH::Ray::Ray(real x, real y, real ang, SDLH::Display* b) {
     /*
     Initializes ray and converts an angle measure into 
     dx and dy.
@@ -585,7 +1372,7 @@ SDLH::Ray::Ray(double x, double y, double ang, SDLH::Display* b) {
     this->b = b;
 }
 
-double SDLH::Ray::lconverge(pair<int, int> a, pair<int, int> b) {
+SDLH::real SDLH::Ray::lconverge(pair<int, int> a, pair<int, int> b) {
     /*
     Checks if the ray hits a line and then returns 
     its distance to that line or 1e9 if it missed. 
@@ -600,7 +1387,7 @@ double SDLH::Ray::lconverge(pair<int, int> a, pair<int, int> b) {
         double rslope = tan(ang); // slope of this ray
         double lslope = ((double)a.second - b.second) / ((double)a.first - (double)b.first); // line slope
         if (rdef && ldef) {
-            point.first = (double)(y + a.second - lslope * a.first - rslope * x) / (lslope - rslope);
+            point.first = (double)(y - a.second + lslope * a.first - rslope * x) / (lslope - rslope);
             point.second = (double)(point.first - x) * rslope + y;
         } else if (!rdef && ldef) {
             point.first = x;
@@ -646,7 +1433,7 @@ double SDLH::Ray::lconverge(pair<int, int> a, pair<int, int> b) {
     return 1e9;
 }
 
-double SDLH::Ray::hconverge(SDL_Rect* hitbox) {
+SDLH::real SDLH::Ray::hconverge(SDL_Rect* hitbox) {
     /*
     Gets the hitbox of an agent or obstacle and then 
     checks if it hits. Then, it returns the distance
@@ -654,7 +1441,7 @@ double SDLH::Ray::hconverge(SDL_Rect* hitbox) {
     */
     int x1 = hitbox->x, y1 = hitbox->y;
     int x2 = x1 + hitbox->w, y2 = y1 + hitbox->h;
-    double ans = 1e9;
+    real ans = 1e9;
     ans = min(ans, lconverge({x1, y1}, {x2, y1}));
     ans = min(ans, lconverge({x1, y1}, {x1, y2}));
     ans = min(ans, lconverge({x1, y2}, {x2, y2}));
@@ -662,7 +1449,7 @@ double SDLH::Ray::hconverge(SDL_Rect* hitbox) {
     return ans;
 }
 
-void SDLH::Ray::update(double x, double y, double ang) {
+void SDLH::Ray::update(real x, real y, real ang) {
     /*
     Update x, y, and angle.
     */
@@ -680,11 +1467,11 @@ void SDLH::Ray::update(double x, double y, double ang) {
     this->dy = sin(this->ang);
 }
 
-double SDLH::Ray::agint(vector<Agent*> v, Agent* avoid) {
+SDLH::real SDLH::Ray::agint(const vector<Agent*>& v, Agent* avoid) {
     /*
     Get closest intersection with agents in vector. 
     */
-    double ans = 1e9;
+    real ans = 1e9;
     for (Agent* a : v) {
         if (a == avoid) continue;
         ans = min(ans, hconverge((*a).hitbox));
@@ -692,11 +1479,11 @@ double SDLH::Ray::agint(vector<Agent*> v, Agent* avoid) {
     return ans;
 }
 
-double SDLH::Ray::obint(vector<Obstacle*> v) {
+SDLH::real SDLH::Ray::obint(const vector<Obstacle*>& v) {
     /*
     Get closest intersection with obstacles in vector. 
     */
-    double ans = 1e9;
+    real ans = 1e9;
     for (Obstacle* a : v) {
         ans = min(ans, hconverge((*a).hitbox));
     }
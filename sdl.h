@@ -9,18 +9,31 @@
 #include <set>
 
 #include "ai.h"
+#include "arena.h"
 #include "constants.h"
 
 namespace SDLH {
+    using AIH::real;
+
     // forward declarations so they can be used before defined
     struct Agent; 
     struct Obstacle;
     struct Ray;
+    struct RayFan;
+    struct SensorCache;
+    struct TickWorker;
     class Debug;
+    class ThreadPool;
+    class Metrics;
+
+    const int TICK_PHASES = 5; // sense, infer, integrate, collide and score, see phasedTick
+    const int QUALITY_LEVELS = 5; // steps of quality a display can give up to meet TICK_BUDGET, see Display::adapt
+    const char* qualityName(int level); // what giving up that level of quality does
     
     class Base { // parent class of all windows
         public:
             Base(int width, int height, std::string title);
+            virtual ~Base() {}
             void initBasics(); // initialize the window but not agents
             virtual void loop(); // mainloop
             void destroy(); // deallocates objects
@@ -37,23 +50,72 @@ namespace SDLH {
     class Display : public Base { // displays the agents' movements
         public:
             Display(int width, int height);
+            ~Display(); // frees the obstacles, agents are owned by whoever added them
             int addAgent(Agent* a); // add to the private agents vector
-            std::vector<Agent*> getAgents(); // get the private agents vector
+            const std::vector<Agent*>& getAgents(); // get the private agents vector
             void removeAgent(Agent* a); // remove agent
             void clearAgents(); // empty the agents vector
             int addObstacle(Obstacle* o);
-            std::vector<Obstacle*> getObstacles();
+            const std::vector<Obstacle*>& getObstacles();
             void clearObstacles();
+            Obstacle* makeObstacle(int x, int y, real dx, real dy, Agent* creator); // new or reused obstacle
+            void reserve(); // allocate up front what ticks need so they don't allocate
             void loop() override; // mainloop
+            void phasedTick(); // what loop updates when THREADS is set, in phases spread over a thread pool
             void createDebug(); // create the debug window if DEBUG_WIND is true
+            double sensorHitRate(); // fraction of ray readings served from sensor caches
+            double reward(); // give the novelty and proximity rewards of this tick
+            void setWorld(int w, int h); // resize the world, which the window shows part of
+            void handle(SDL_Event& e); // pan and zoom the camera with WASD, +/-, the mouse wheel and dragging
+            bool visible(double x, double y, double w, double h); // whether part of a world rectangle is in the window
+            float screenX(double x); // window position of a world position
+            float screenY(double y);
+            void measureCosts(); // find the cost range agents are colored by, once per frame
+            void line(float x1, float y1, float x2, float y2, SDL_Color c); // queue a one pixel wide line in window coordinates
+            void render(); // draw everything queued with one call per kind and empty the queues
+            void adapt(double ms); // step quality down or up when ticks keep missing or beating TICK_BUDGET
+            double delta(Uint32 since); // how far to move something last moved at since, in SDL ticks
+            int rayStride(); // only every this many rays are cast, the others copy them
+            int controlRate(); // ticks between network evaluations at the current quality
+            int noveltyStride(); // agents are compared with every this many others for the novelty bonus
 
             Debug* db; // pointer to a debug window
-            // objects in these sets will be deleted.
-            std::set<Agent*> dela;
-            std::set<Obstacle*> delo;
+            long long sensorHits, sensorMisses; // ray readings reused and recast by sensor caches
+            long long ticks; // amount of times loop has run
+            bool headless; // skip events and rendering, set from HEADLESS
+            double step; // if above 0, how far each tick advances instead of the real time elapsed
+            int agentIds; // ids handed out to agents since they were last cleared
+            int obstacleIds; // ids handed out to obstacles
+            int worldWidth, worldHeight; // bounds of physics and sensing, independent of the window
+            double diagonal; // length of the world's diagonal, the longest any ray can see
+            double camX, camY; // world position shown at the window's top left corner
+            double zoom; // window pixels per world unit
+            double leastCost, mostCost; // cost range of this frame's agents
+            // geometry queued by draw calls, submitted together by render
+            std::vector<SDL_Vertex> vertices;
+            std::vector<int> indices;
+            std::vector<SDL_FRect> boxes; // obstacles
+            Arena scratch; // memory that is only used within one tick
+            // state of phasedTick
+            ThreadPool* threads; // NULL until THREADS is first used
+            std::vector<TickWorker*> workers; // what each thread of the pool writes to
+            std::vector<real*> inputs; // observation of each agent that runs its network this tick, in worker scratch
+            std::vector<int> hits; // agents each obstacle hit this tick
+            std::vector<char> outside; // whether each obstacle left the world this tick
+            std::vector<double> bonuses; // novelty bonus of each agent, see reward
+            double phaseMs[TICK_PHASES]; // how long each phase of the last phased tick took
+            Metrics* metrics; // where the state is published after every tick, NULL if nowhere
+            int quality; // levels of quality given up to keep ticks within TICK_BUDGET, 0 is full quality
+            double tickMs; // how long the last tick took
+            double averageMs; // moving average of how long ticks take
+            int settled; // ticks since quality last changed
+            // objects in these vectors will be deleted at the end of the tick.
+            std::vector<Agent*> dela;
+            std::vector<Obstacle*> delo;
         private:
             std::vector<Agent*> agents; // stores all agents
             std::vector<Obstacle*> obstacles;
+            std::vector<Obstacle*> pool; // removed obstacles waiting to be reused
     };
     
     class Debug : public Base { // displays one agent's neural network. Shouldn't function independently from Display
@@ -68,52 +130,116 @@ namespace SDLH {
     };
     
     struct Obstacle {
-        Obstacle(int x, int y, double dx, double dy, Display* b, Agent* creator);
+        Obstacle(int x, int y, real dx, real dy, Display* b, Agent* creator);
+        ~Obstacle();
+        void reset(int x, int y, real dx, real dy, Agent* creator); // reuse as a new obstacle
         void update(Display* b);
+        bool move(Display* b); // move without checking for hits, returns whether it left the world
         void draw(Display* b);
 
         SDL_Rect* hitbox;
-        std::pair<double, double> pos;
-        double dx, dy;
+        std::pair<real, real> pos;
+        real dx, dy;
         Uint32 starttick;
         Agent* creator;
+        int id; // unique among the obstacles of its display
     };
 
+    enum CostPart { // where an agent's cost comes from, see Agent::charge
+        FIRE_PART, // FIRE_COST of every shot
+        STRUCK_PART, // HIT_COST of every hit taken
+        HIT_PART, // HIT_REWARD of every hit dealt
+        NOVELTY_PART,
+        PROXIMITY_PART,
+        COST_PARTS
+    };
+    const char* costPartName(int part);
+
     struct Agent {
         Agent(int x, int y, double dir, int side, Display* b);
+        ~Agent();
+        void respawn(int x, int y, double dir); // reset position and state, keeping the network
+        void observe(Display* b, real* out, TickWorker* w=NULL); // write what the agent senses, one value per input neuron
         void update(Display* b); // change the position and direction and other factors
+        bool due(Display* b); // whether the network runs this tick instead of repeating the last action
+        void move(Display* b, TickWorker* w=NULL); // steer and move by the action, firing into w's queue if given
         void draw(Display* b); // draw agent onto speed
         double getRay(Display* b, double dir, std::vector<SDL_Rect*> boxes); // cast a ray in a direction and find distance to collision. 
         // Maximum of SIGHTRAD, result divided by sightrad
-        void fire(Display* b, double dir);
+        void fire(Display* b, real dir, TickWorker* w=NULL); // shots are queued in w instead of added to b if it is given
+        void charge(CostPart part, double amount); // add to the cost and to the part of it that amount is
 
         SDL_Rect* hitbox; // hitbox - do not use to get actual position
-        std::pair<double, double> pos; // hitbox's values can only be ints, so this is used as a workaround
-        double dir; // direction
-        double speed; // speed
-        double angvel; // angular velocity
+        std::pair<real, real> pos; // hitbox's values can only be ints, so this is used as a workaround
+        real dir; // direction
+        real speed; // speed
+        real angvel; // angular velocity
         Uint32 starttick; // used with SDL_GetTick() to find time elapsed between frames
         int side; // faction
         int health;
-        double cooldown; // firing cooldown
+        real cooldown; // firing cooldown
 
         AIH::Network* nn; // neural network
         double cost;
+        double parts[COST_PARTS]; // cost split by where it came from
+        std::vector<real> action; // last outputs of nn, repeated until it is run again
+        bool external; // action is set from outside instead of by running nn
+        int phase; // offset of the ticks this agent runs nn on, so agents are spread out over any control rate
+        int id; // index among the agents added to the display
 
-        std::vector<Ray*> rays; // sight
+        RayFan* fan; // sight
+        SensorCache* sensor; // reuses ray readings between ticks
+    };
+
+    struct Spawn { // an obstacle an agent fired during a phased tick, added once the phase is over
+        real x, y, dx, dy;
+        Agent* creator;
+    };
+
+    struct TickWorker { // what one thread writes to during a phased tick instead of the display
+        TickWorker();
+
+        Arena scratch;
+        long long sensorHits, sensorMisses; // added to the display's after the tick
+        std::vector<Spawn> spawns;
+    };
+
+    double rayOffset(int i); // angle of the i-th ray relative to the direction of its agent
+
+    enum Channel { // kinds of things rays can see, each is a separate set of inputs
+        AGENT_CHANNEL,
+        OBSTACLE_CHANNEL,
+        WALL_CHANNEL // the edges of the display, hit ids 0 to 3 are left, top, right and bottom
+    };
+    const std::vector<Channel>& senseChannels(); // channels in SENSE_CHANNELS, in input order
+    void prepareShared(); // builds the tables every agent shares, to be called before threads make agents
+
+    struct RayFan { // all rays of one agent, kept as arrays so they can be processed together
+        RayFan();
+        void aim(real x, real y, real dir); // move the fan and rotate it to face dir
+        // distances and ids of the closest thing in each channel, RAY_AMOUNT per channel
+        void cast(Display* b, Agent* avoid, const char* which, real* res, int* ids);
+        real hit(int i, SDL_Rect* hitbox); // distance along ray i to a hitbox or 1e9 if it misses
+        // keeps the closest hit of a hitbox in r and ids, only for the rays in its angular span
+        // that are a multiple of every
+        void project(SDL_Rect* hitbox, int id, const char* which, real* r, int* ids, int every=1);
+
+        real x, y; // where all rays start
+        real dir; // direction the fan faces in degrees
+        std::vector<real> dx, dy; // direction of each ray
     };
 
     struct Ray {
-        Ray(double x, double y, double ang, Display* b); // ray constructor
-        double lconverge(std::pair<int, int> a, std::pair<int, int> b); // check intersection with line
-        double hconverge(SDL_Rect* hitbox); // check intersection with hitbox
-        void update(double x, double y, double ang); // change 
-        double agint(std::vector<Agent*> v, Agent* avoid); // get closest intersection with agents
-        double obint(std::vector<Obstacle*> v); // get closest intersection with obstacles
-
-        double x, y;
-        double dx, dy;
-        double ang;
+        Ray(real x, real y, real ang, Display* b); // ray constructor
+        real lconverge(std::pair<int, int> a, std::pair<int, int> b); // check intersection with line
+        real hconverge(SDL_Rect* hitbox); // check intersection with hitbox
+        void update(real x, real y, real ang); // change 
+        real agint(const std::vector<Agent*>& v, Agent* avoid); // get closest intersection with agents
+        real obint(const std::vector<Obstacle*>& v); // get closest intersection with obstacles
+
+        real x, y;
+        real dx, dy;
+        real ang;
         Display* b;
     };
 };
\ No newline at end of file
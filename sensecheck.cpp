@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "race.h"
+#include "sdl.h"
+#include "config.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+Checks that DEPTH_SENSING sees what casting every ray sees.
+
+    ./sensecheck SCENES [KEY=VALUE ...]
+
+Every scene scatters AGENT_AMOUNT agents over the world and aims a fan from
+a random point in a random direction. Its agent channel is cast with and
+without DEPTH_SENSING, which have to give the same distances and ids, and
+every ray is compared with Ray::agint, which has to find the same distance
+within TOLERANCE pixels. Ray tests whether a hit lies on an edge with exact
+comparisons, so rounding makes it miss some edges. Where it reports a
+farther distance or none, Ray::hconverge has to miss the edge where the ray
+enters the agent depth sensing saw first as well. Those rays are counted,
+and any other difference fails the check with exit code 1.
+*/
+
+// pixels, a float build (see precision.h) only gets within a few hundredths
+const double TOLERANCE = sizeof(SDLH::real) < sizeof(double) ? 0.05 : 1e-3;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: ./sensecheck SCENES [KEY=VALUE ...]\n";
+        return 1;
+    }
+    int scenes = stoi(argv[1]);
+    vector<char*> rest = {argv[0], (char*)"HEADLESS=true", (char*)"SENSE_CHANNELS=agents"};
+    for (int i = 2; i < argc; i ++) rest.push_back(argv[i]);
+    if (!CFGH::parseArgs(rest.size(), rest.data())) {
+        return 1;
+    }
+    SDLH::prepareShared();
+    SDLH::Display* b = SDLH::makeArena();
+    mt19937 mt(1);
+    for (int k = 0; k < AGENT_AMOUNT; k ++) SDLH::spawnAgent(b, new AIH::Network(), mt);
+    uniform_real_distribution<double> distx(0, b->worldWidth), disty(0, b->worldHeight), dist2(0, 360);
+    uniform_int_distribution<int> spotx(0, b->worldWidth), spoty(0, b->worldHeight);
+
+    SDLH::RayFan fan;
+    vector<char> which(RAY_AMOUNT, 1);
+    vector<SDLH::real> full(RAY_AMOUNT), depth(RAY_AMOUNT);
+    vector<int> fullIds(RAY_AMOUNT), depthIds(RAY_AMOUNT);
+    long long rays = 0, castDiffs = 0, agreed = 0, rayDiffs = 0, missed = 0;
+    double worst = 0;
+    for (int s = 0; s < scenes; s ++) {
+        for (SDLH::Agent* a : b->getAgents()) a->respawn(spotx(mt), spoty(mt), dist2(mt));
+        double x = distx(mt), y = disty(mt), dir = dist2(mt);
+        fan.aim(x, y, dir);
+        DEPTH_SENSING = false;
+        fan.cast(b, NULL, which.data(), full.data(), fullIds.data());
+        DEPTH_SENSING = true;
+        fan.cast(b, NULL, which.data(), depth.data(), depthIds.data());
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            rays ++;
+            if (full[i] != depth[i] || fullIds[i] != depthIds[i]) castDiffs ++;
+            SDLH::Ray ray(x, y, dir + SDLH::rayOffset(i), b);
+            double d = ray.agint(b->getAgents(), NULL);
+            if (fabs(d - depth[i]) <= TOLERANCE) {
+                agreed ++;
+                continue;
+            }
+            // ids are indices, since the agents are never removed
+            if (d > depth[i] && ray.hconverge(b->getAgents()[depthIds[i]]->hitbox) > depth[i] + TOLERANCE) {
+                missed ++;
+            } else {
+                rayDiffs ++;
+                worst = max(worst, fabs(d - depth[i]));
+            }
+        }
+    }
+    cout << rays << " rays over " << scenes << " scenes of " << AGENT_AMOUNT << " agents\n";
+    cout << "  differing from the cast of every ray: " << castDiffs << "\n";
+    cout << "  within " << TOLERANCE << " of Ray::agint: " << agreed << "\n";
+    cout << "  differing from Ray::agint by more than " << TOLERANCE << ": " << rayDiffs;
+    if (rayDiffs > 0) cout << " (largest difference " << worst << ")";
+    cout << "\n  edges Ray::agint misses: " << missed << "\n";
+    return castDiffs == 0 && rayDiffs == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "sensor.h"
+#include "constants.h"
+
+using namespace std;
+
+/*
+SensorCache
+*/
+
+SDLH::SensorCache::SensorCache() {
+    /*
+    Constructor for SensorCache. Nothing is cached until the first sense.
+    */
+    dists = vector<real> (senseChannels().size() * RAY_AMOUNT, 1e9);
+    ids = vector<int> (senseChannels().size() * RAY_AMOUNT, -1);
+    age = vector<int> (RAY_AMOUNT, 0);
+    pos = {0, 0};
+    dir = 0;
+    valid = false;
+}
+
+void SDLH::SensorCache::invalidate() {
+    /*
+    Throws away the cached readings so the next sense recasts every ray.
+    */
+    valid = false;
+    fill(known.begin(), known.end(), 0);
+}
+
+void SDLH::SensorCache::mark(Agent* a, pair<real, real> p, char* dirty) {
+    /*
+    Flags the rays of agent a that could cross a hitbox whose corner is at p.
+    The hitbox is padded by a pixel to cover the rounding done on SDL_Rect,
+    and anything that wraps around behind the agent marks every ray.
+    */
+    double x1 = floor(p.first) - 1, y1 = floor(p.second) - 1;
+    double x2 = x1 + AGENT_SIZE + 2, y2 = y1 + AGENT_SIZE + 2;
+    bool inside = a->pos.first >= x1 && a->pos.first <= x2 && a->pos.second >= y1 && a->pos.second <= y2;
+    double lo = 360, hi = -360;
+    pair<double, double> corners[4] = {{x1, y1}, {x2, y1}, {x1, y2}, {x2, y2}};
+    for (auto c : corners) {
+        // same angle convention as the rays: counterclockwise with y pointing down
+        double ang = atan2(-(c.second - a->pos.second), c.first - a->pos.first) * 180 / M_PI;
+        double rel = ang - a->dir;
+        rel -= 360 * floor((rel + 180) / 360);
+        lo = min(lo, rel);
+        hi = max(hi, rel);
+    }
+    for (int i = 0; i < RAY_AMOUNT; i ++) {
+        double off = rayOffset(i);
+        if (inside || hi - lo > 180 || (off >= lo - 1 && off <= hi + 1)) {
+            dirty[i] = 1;
+        }
+    }
+}
+
+void SDLH::SensorCache::sense(Agent* a, Display* b, real* out, TickWorker* w) {
+    /*
+    Writes the reading of every ray of every channel into out. The cache only
+    covers the agent channel: an agent ray is only recast if the agent moved
+    or turned more than the tolerance since the last full cast, if another agent
+    moved more than the tolerance inside its part of the view cone, or if its
+    reading has gone SENSOR_REFRESH ticks without being refreshed.
+    Scratch flags come from the display's arena so sensing doesn't allocate,
+    or from w's during a phased tick so threads don't share it.
+    */
+    Arena& scratch = w != NULL ? w->scratch : b->scratch;
+    long long& hits = w != NULL ? w->sensorHits : b->sensorHits;
+    long long& misses = w != NULL ? w->sensorMisses : b->sensorMisses;
+    const vector<Agent*>& agents = b->getAgents();
+    if ((int)seen.size() < b->agentIds) {
+        seen.resize(b->agentIds);
+        known.resize(b->agentIds, 0);
+    }
+    char* dirty = scratch.alloc<char>(RAY_AMOUNT);
+    double moved = hypot(a->pos.first - pos.first, a->pos.second - pos.second);
+    double turned = fabs(a->dir - dir);
+    turned = min(turned, 360 - turned);
+    if (!SENSOR_CACHE || !valid || moved > SENSOR_TOLERANCE || turned > SENSOR_ANGLE_TOLERANCE) {
+        // full cast: every ray is recast and all other agents are remembered where they are now
+        fill(dirty, dirty + RAY_AMOUNT, 1);
+        fill(known.begin(), known.end(), 0);
+        for (Agent* o : agents) {
+            if (o == a) continue;
+            seen[o->id] = o->pos;
+            known[o->id] = 1;
+        }
+        pos = a->pos;
+        dir = a->dir;
+        valid = true;
+    } else {
+        char* present = scratch.alloc<char>(seen.size());
+        for (Agent* o : agents) {
+            if (o == a) continue;
+            present[o->id] = 1;
+            if (!known[o->id]) { // appeared
+                mark(a, o->pos, dirty);
+                seen[o->id] = o->pos;
+                known[o->id] = 1;
+            } else if (hypot(o->pos.first - seen[o->id].first, o->pos.second - seen[o->id].second) > SENSOR_TOLERANCE) {
+                // both where it was and where it is now may have changed
+                mark(a, seen[o->id], dirty);
+                mark(a, o->pos, dirty);
+                seen[o->id] = o->pos;
+            }
+        }
+        for (int i = 0; i < (int)seen.size(); i ++) { // removed
+            if (known[i] && !present[i]) {
+                mark(a, seen[i], dirty);
+                known[i] = 0;
+            }
+        }
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            if (age[i] >= SENSOR_REFRESH) dirty[i] = 1;
+        }
+    }
+    // the fan was aimed at the end of the agent's last update, which is where it still is
+    // and the agent rays that aren't dirty keep their cached distances
+    const vector<Channel>& channels = senseChannels();
+    a->fan->cast(b, a, dirty, dists.data(), ids.data());
+    real diagonal = b->diagonal;
+    for (int c = 0; c < (int)channels.size(); c ++) {
+        for (int i = c * RAY_AMOUNT; i < (c + 1) * RAY_AMOUNT; i ++) {
+            // 1 if nothing was seen, otherwise relative to the longest possible length
+            out[i] = dists[i] == (real)1e9 ? 1 : dists[i] / diagonal;
+        }
+        if (channels[c] != AGENT_CHANNEL) continue;
+        for (int i = 0; i < RAY_AMOUNT; i ++) {
+            if (dirty[i]) {
+                age[i] = 0;
+                misses ++;
+            } else {
+                age[i] ++;
+                hits ++;
+            }
+        }
+    }
+}
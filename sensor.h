@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "sdl.h"
+#include "constants.h"
+
+namespace SDLH {
+    struct SensorCache { // remembers an agent's ray readings so only rays affected by movement are recast
+        SensorCache();
+        void sense(Agent* a, Display* b, real* out, TickWorker* w=NULL); // writes the ray readings of every channel into out
+        void invalidate(); // forces every ray to be recast on the next sense
+        void mark(Agent* a, std::pair<real, real> p, char* dirty); // flags the rays that a hitbox at p could cross
+
+        std::vector<real> dists; // last distance each ray of each channel saw, as laid out by RayFan::cast
+        std::vector<int> ids; // id of what each ray of each channel saw, -1 for nothing
+        std::vector<int> age; // ticks since each agent ray was last cast
+        std::pair<real, real> pos; // observer position at the last full cast
+        real dir; // observer direction at the last full cast
+        bool valid; // false until the first full cast
+        std::vector<std::pair<real, real>> seen; // positions of other agents by id when their rays were last cast
+        std::vector<char> known; // whether the agent with that id is in seen
+    };
+};
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "steady.h"
+#include "race.h"
+#include "constants.h"
+
+using namespace std;
+
+vector<AIH::Network*> SDLH::offspring(const vector<pair<double, string>>& survivors, int amount, AIH::Rng& r) {
+    /*
+    The distinct survivors at the front are the parents of the ones that
+    get mutated. With fewer survivors than SURVIVOR_REPRODUCTION the copies
+    cycle through the ones there are.
+    */
+    int parents = min((int)survivors.size(), SURVIVOR_REPRODUCTION);
+    vector<AIH::Network*> nets;
+    for (int i = 0; i < amount; i ++) {
+        AIH::Network* nn;
+        if (i < SURVIVOR_REPRODUCTION * (int)survivors.size()) {
+            nn = new AIH::Network(survivors[i % parents].second);
+        } else {
+            nn = new AIH::Network();
+        }
+        if (SPARSE && !nn->sparse) {
+            nn->prune(PRUNE_THRESHOLD);
+        }
+        nets.push_back(nn);
+    }
+    // mutate the first ones all at once
+    AIH::breed(nets, (int)ceil(amount * MUTATION_CHANCE), parents, MUTATION_AMOUNT, r);
+    return nets;
+}
+
+bool SDLH::evolveSteady(Metrics* metrics, AIH::Archive* archive, vector<pair<double, string>> population, vector<double>& bests) {
+    /*
+    The population is the best STEADY_POPULATION survivors of every arena so
+    far, each with the cost it had in its arena, and it is only locked to
+    copy out the parents of an arena and to merge survivors back in. Breeding
+    and running an arena happen outside of the lock, with a generator and a
+    display of the thread's own, so threads only wait on each other for
+    those copies. Arenas that start before others finish breed from an
+    older population, which is what lets the threads run without barriers.
+    */
+    int workers = STEADY_WORKERS > 0 ? STEADY_WORKERS : max((int)thread::hardware_concurrency(), 1);
+    int capacity = STEADY_POPULATION > 0 ? STEADY_POPULATION : AGENT_AMOUNT;
+    mutex lock;
+    double least = 0; // lowest cost any arena had so far
+    int started = 0;
+    bool failed = false;
+    vector<double> busy(workers, 0); // seconds each thread spent breeding and running arenas
+    prepareShared();
+
+    auto now = [] () { return chrono::steady_clock::now(); };
+    auto evaluate = [&] (int w) {
+        random_device rd;
+        mt19937 mt(rd());
+        AIH::Rng r(((uint64_t)rd() << 32) | rd());
+        Display* b = makeArena();
+        vector<pair<double, string>> parents, survivors;
+        while (true) {
+            {
+                lock_guard<mutex> hold(lock);
+                if (failed || started >= EPOCH_AMOUNT) break;
+                started ++;
+                parents.assign(population.begin(), population.begin() + min((int)population.size(), SURVIVOR_REPRODUCTION));
+            }
+            auto start = now();
+            vector<AIH::Network*> nets = offspring(parents, AGENT_AMOUNT, r);
+            vector<Agent*> agents;
+            for (AIH::Network* nn : nets) agents.push_back(spawnAgent(b, nn, mt));
+            bool ok = runEpisode(b, EPOCH_LENGTH, NULL, false) >= 0;
+            survivors.clear();
+            for (Agent* a : b->getAgents()) {
+                survivors.push_back({a->cost, a->nn->store()});
+            }
+            for (Agent* a : agents) delete a;
+            b->clearAgents();
+            b->clearObstacles();
+            busy[w] += chrono::duration<double>(now() - start).count();
+
+            lock_guard<mutex> hold(lock);
+            if (!ok) {
+                failed = true;
+                break;
+            }
+            if (survivors.empty()) continue;
+            sort(survivors.begin(), survivors.end());
+            if (bests.empty() || survivors[0].first < least) {
+                least = survivors[0].first;
+                if (NETWORK_PATH != "") {
+                    AIH::Network(survivors[0].second).store(NETWORK_PATH);
+                }
+            }
+            if (archive != NULL) archive->addElites(survivors);
+            bests.push_back(survivors[0].first);
+            cout << "Minimum cost: " << survivors[0].first << "\n";
+            if (metrics != NULL) {
+                metrics->epoch(bests.size(), survivors[0].first);
+            }
+            // the worst are replaced as soon as better ones come in
+            population.insert(population.end(), survivors.begin(), survivors.end());
+            sort(population.begin(), population.end());
+            if ((int)population.size() > capacity) population.resize(capacity);
+        }
+        delete b;
+    };
+
+    auto begin = now();
+    vector<thread> threads;
+    for (int w = 1; w < workers; w ++) threads.push_back(thread(evaluate, w));
+    evaluate(0);
+    for (thread& t : threads) t.join();
+    double wall = chrono::duration<double>(now() - begin).count();
+    double total = 0;
+    for (double s : busy) total += s;
+    cout << "Evaluator utilization: " << total / max(wall * workers, 1e-9) << " over " << workers << " threads\n";
+    return !failed;
+}
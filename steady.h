@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "ai.h"
+#include "genetic.h"
+#include "metrics.h"
+#include "archive.h"
+
+namespace SDLH {
+    // Networks for the next arena: copies of the best SURVIVOR_REPRODUCTION
+    // stored survivors, sorted by cost, topped up with random networks, with
+    // the first MUTATION_CHANCE of them bred from those survivors.
+    std::vector<AIH::Network*> offspring(const std::vector<std::pair<double, std::string>>& survivors, int amount, AIH::Rng& r);
+
+    // Steady-state evolution: STEADY_WORKERS threads each run headless arenas
+    // one after another, breeding every arena from the population as it is
+    // when the arena starts and merging its survivors back as soon as it ends,
+    // so no thread waits for the others. Starts from population, sorted by
+    // cost, and adds the best ARCHIVE_ELITES of each arena to archive if there
+    // is one. Runs EPOCH_AMOUNT arenas in total and adds the minimum cost of
+    // each to bests, in the order they finished. Returns false if
+    // CHECK_ALLOCATIONS caught an episode allocating.
+    bool evolveSteady(Metrics* metrics, AIH::Archive* archive, std::vector<std::pair<double, std::string>> population, std::vector<double>& bests);
+};
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+#include "config.h"
+#include "constants.h"
+
+using namespace std;
+
+string quote(string s) {
+    /*
+    Wraps an argument in single quotes so the shell passes it through unchanged.
+    */
+    string res = "'";
+    for (char c : s) {
+        if (c == '\'') res += "'\\''";
+        else res += c;
+    }
+    return res + "'";
+}
+
+vector<CFGH::SweepRun> CFGH::expand(string path) {
+    /*
+    Reads a grid file where each line is KEY=v1,v2,... and returns every
+    combination of the listed values. Lines are expanded in order, so the
+    last line changes fastest.
+    */
+    vector<SweepRun> runs = {SweepRun{{}, false, 0, 0}};
+    ifstream fin(path);
+    if (!fin) {
+        cout << "Sweep file " << path << " not found\n";
+        return {};
+    }
+    string line;
+    while (getline(fin, line)) {
+        line = line.substr(0, line.find('#'));
+        size_t eq = line.find('=');
+        if (eq == string::npos) continue;
+        string key = line.substr(0, eq);
+        key.erase(remove_if(key.begin(), key.end(), ::isspace), key.end());
+        // check the key exists before spending any time on it
+        if (!exists(key)) {
+            cout << "Unknown sweep parameter: " << key << "\n";
+            return {};
+        }
+        vector<string> values;
+        stringstream ss(line.substr(eq + 1));
+        string cur;
+        // sizes uses commas itself, so its values are separated by semicolons
+        while (getline(ss, cur, key == "sizes" ? ';' : ',')) {
+            cur.erase(remove_if(cur.begin(), cur.end(), ::isspace), cur.end());
+            if (cur != "") values.push_back(cur);
+        }
+        vector<SweepRun> next;
+        for (SweepRun r : runs) {
+            for (string v : values) {
+                SweepRun n = r;
+                n.values.push_back({key, v});
+                next.push_back(n);
+            }
+        }
+        runs = next;
+    }
+    return runs;
+}
+
+vector<CFGH::SweepRun> CFGH::sweep(string path, string exe) {
+    /*
+    Runs every combination in the grid as a separate headless process of exe,
+    keeping one process per core busy until the grid is done. Each process
+    reports its result on a line starting with RESULT.
+    */
+    vector<SweepRun> runs = expand(path);
+    if (runs.empty()) return runs;
+    int workers = max(1u, thread::hardware_concurrency());
+    cout << "Sweeping " << runs.size() << " configurations on " << workers << " cores\n";
+    atomic<int> next(0);
+    mutex lock;
+    auto work = [&] () {
+        while (true) {
+            int i = next ++;
+            if (i >= (int)runs.size()) return;
+            // shared settings first so the swept values override them
+            string cmd = quote(exe);
+            for (string a : passed) cmd += " " + quote(a);
+            cmd += " HEADLESS=true NETWORK_PATH=";
+            for (auto kv : runs[i].values) cmd += " " + quote(kv.first + "=" + kv.second);
+            cmd += " 2>&1";
+            FILE* out = popen(cmd.c_str(), "r");
+            if (!out) continue;
+            char buf[512];
+            while (fgets(buf, sizeof(buf), out)) {
+                string l = buf;
+                if (l.rfind("RESULT ", 0) != 0) continue;
+                stringstream ss(l.substr(7));
+                if (ss >> runs[i].best >> runs[i].mean) runs[i].ok = true;
+            }
+            pclose(out);
+            lock.lock();
+            cout << "Finished " << i + 1 << "/" << runs.size() << (runs[i].ok ? "" : " (failed)") << "\n";
+            lock.unlock();
+        }
+    };
+    vector<thread> pool;
+    for (int i = 0; i < workers; i ++) pool.push_back(thread(work));
+    for (thread& t : pool) t.join();
+    return runs;
+}
+
+void CFGH::report(vector<SweepRun> runs, string path) {
+    /*
+    Prints the sweep results as one table sorted by best cost, and writes
+    the same table as csv if a path is given.
+    */
+    if (runs.empty()) return;
+    sort(runs.begin(), runs.end(), [] (const SweepRun& a, const SweepRun& b) {
+        if (a.ok != b.ok) return a.ok;
+        return a.best < b.best;
+    });
+    vector<string> head;
+    for (auto kv : runs[0].values) head.push_back(kv.first);
+    head.push_back("best");
+    head.push_back("mean");
+    vector<vector<string>> rows;
+    for (SweepRun r : runs) {
+        vector<string> row;
+        for (auto kv : r.values) row.push_back(kv.second);
+        row.push_back(r.ok ? to_string(r.best) : "failed");
+        row.push_back(r.ok ? to_string(r.mean) : "failed");
+        rows.push_back(row);
+    }
+    vector<size_t> width;
+    for (string h : head) width.push_back(h.size());
+    for (auto row : rows) {
+        for (size_t i = 0; i < row.size(); i ++) width[i] = max(width[i], row[i].size());
+    }
+    auto print = [&] (vector<string> row) {
+        for (size_t i = 0; i < row.size(); i ++) {
+            cout << row[i] << string(width[i] - row[i].size() + 2, ' ');
+        }
+        cout << "\n";
+    };
+    print(head);
+    for (auto row : rows) print(row);
+    if (path != "") {
+        ofstream fout(path);
+        for (size_t i = 0; i < head.size(); i ++) fout << head[i] << (i + 1 < head.size() ? "," : "\n");
+        for (auto row : rows) {
+            // sizes contains commas, so every cell is quoted
+            for (size_t i = 0; i < row.size(); i ++) fout << "\"" << row[i] << "\"" << (i + 1 < row.size() ? "," : "\n");
+        }
+    }
+}